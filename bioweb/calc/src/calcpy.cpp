@@ -17,34 +17,50 @@
 #include <boost/python/suite/indexing/vector_indexing_suite.hpp>
 
 #include "calc.hpp"
+#include <bayesian_webclass/classifier_service.h>
 #include <string>
-#include <cstdlib>
-#include <cstdio>
 #include <iostream>
-#include <memory>
-#include <stdexcept>
-#include <array>
 
 
-/** system("") wrapper to execute command and get the output
- *  
- * @param command to execute
+/** default location of the installed classifier data (catkin install of bayesian_webclass) */
+static const std::string DATA_DIR("/home/apiotro/zpr/catkin_ws/install/lib/bayesian_webclass/");
+
+/** the classifier service living as long as the python module
  */
 
+static ClassifierService& service() {
+    static ClassifierService s;
+    return s;
+}
 
-std::string exec(const char* cmd) { 
-    std::array<char, 128> buffer;
-    std::string result;
-    std::shared_ptr<FILE> pipe(popen(cmd, "r"), pclose);
-    if (!pipe) throw std::runtime_error("popen() failed!");
-    while (!feof(pipe.get())) {
-        if (fgets(buffer.data(), 128, pipe.get()) != NULL)
-            result += buffer.data();
-    }
-    return std::string("") + static_cast<std::string>(result);
+/** trains the classifier kept in memory by the module
+ *
+ * @param attributes name of the file listing all attributes
+ * @param categories name of the file listing all categories
+ * @param examples_dir directory containing examples
+ * @param examples_num number of examples to be used
+ * @return true if the classifier was trained
+ */
+
+bool init(const std::string attributes, const std::string categories,
+          const std::string examples_dir, int examples_num)
+{
+    return service().init(attributes, categories, examples_dir, examples_num);
+}
+
+/** loads the classifier kept in memory by the module from a snapshot file
+ *
+ * @param snapshot name of the file written by make_snapshot
+ * @return true if the snapshot was loaded
+ */
+
+bool load(const std::string snapshot)
+{
+    return service().load(snapshot);
 }
 
-/** harsh adapter to use the classificator
+/** adapter to use the classificator; on the first call, if neither init nor load was called,
+ *  loads the installed snapshot or trains the classifier if there is none
  *  
  * @param web address to clasify
  */
@@ -52,20 +68,40 @@ std::string exec(const char* cmd) {
 
 std::string classify(const std::string word) 
 {   
-
-    std::string response;   //too complicated to export whole classifier as a python module.......
-    std::string query =  std::string("/home/apiotro/zpr/catkin_ws/install/lib/bayesian_webclass/test_p ") + "\"" + std::string(word) + "\""; 
-    response = exec(query.c_str());         
-    std::cout << response;
+    service().initOnce(DATA_DIR + "model.snapshot",
+                       DATA_DIR + "all_atributes.txt.txt",
+                       DATA_DIR + "categories/list_of_categories.txt",
+                       DATA_DIR + "output/",
+                       224);
+    std::string response;
+    if(!service().classify(word, response)) {
+        response = "";
+    }
+    std::cout << response << std::endl;
     return word + " " + response;  
 }
 
+/** adds a labelled article to the classifier kept in memory (online learning),
+ *  needs the classifier trained by init or by the first classify without a snapshot
+ *
+ * @param word web address of the article
+ * @param category name of the category of the article
+ * @return true if the article was learned
+ */
+
+bool learn(const std::string word, const std::string category)
+{
+    return service().learn(word, category);
+}
+
 /**
  * Python wrapper using Boost.Python
  */
 BOOST_PYTHON_MODULE( calc )
 {
     using namespace boost::python;
+    def("init", init);
+    def("load", load);
     def("classify", classify);
+    def("learn", learn);
 }
-
@@ -0,0 +1,75 @@
+#ifndef ASYNC_DOWNLOADER_H
+#define ASYNC_DOWNLOADER_H
+
+#include <string>
+#include <deque>
+#include <map>
+#include <functional>
+#include <memory>
+#include "page_cache.h"
+#include "download_session.h"
+
+/**\class AsyncDownloader
+ * \brief Concurrent downloading of many urls.
+ * Urls are queued with add and downloaded by run on a single
+ * curl multi handle, up to max_in_flight transfers at once and
+ * up to max_per_host transfers to the same host. Every finished
+ * transfer is delivered to its callback, in the order of completion,
+ * from the thread calling run. Transfers use the DownloadSession,
+ * so transfers to the same host are multiplexed over HTTP/2.
+ * With a PageCache set, fresh cached pages are delivered without
+ * downloading and stale ones are revalidated.
+ * Urls added with check are only probed for liveness: a HEAD request,
+ * or a GET of the first byte if the server does not answer HEAD.
+ * Urls produced by another thread are taken by a Source given to run,
+ * the producer calls wakeup when it has new urls.
+ */
+class AsyncDownloader
+{
+public:
+    /** called with the url, true if the download succeeded and the downloaded body,
+     *  the body may be moved out by the callback */
+    typedef std::function<void(const std::string &url, bool success, std::string &body)> Callback;
+    /** called with the url, the HTTP status (0 if there was no response) and the time of the check in seconds */
+    typedef std::function<void(const std::string &url, long status, double seconds)> CheckCallback;
+    /** called by run to add more urls without blocking, returns false when no more urls will come */
+    typedef std::function<bool()> Source;
+
+    AsyncDownloader(int max_in_flight = 32, int max_per_host = 8, long timeout = 5,
+                    std::shared_ptr<DownloadSession> session = std::shared_ptr<DownloadSession>());
+    virtual ~AsyncDownloader();
+
+    void add(const std::string &url, const Callback &callback);
+    void check(const std::string &url, const CheckCallback &callback);
+    void run(const Source &source = Source());
+    void wakeup();
+    void setCache(const PageCache *cache);
+    std::size_t pending() const;
+
+    static std::string getHost(const std::string &url);
+
+private:
+    struct Transfer;
+
+    AsyncDownloader(const AsyncDownloader &);               //noncopyable
+    AsyncDownloader &operator=(const AsyncDownloader &);    //noncopyable
+
+    void startTransfers();
+    void finishTransfer(void *easy, int result);
+    void deliver(Transfer *t, bool success);
+    bool finishCheck(Transfer *t, int result, long status, double seconds);
+
+    std::shared_ptr<DownloadSession> _session;
+    void *_multi;
+    int _max_in_flight;
+    int _max_per_host;
+    long _timeout;
+    int _in_flight;
+    std::deque<Transfer *> _queue;
+    std::deque<Transfer *> _cached;    //fresh cached pages waiting for delivery
+    const PageCache *_cache;
+    std::map<std::string, int> _host_in_flight;
+};
+
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef BERNOULLI_MODEL_H
+#define BERNOULLI_MODEL_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/** sparse example: sorted ids of attributes present in the example */
+typedef std::vector<int> SparseExample;
+
+/** ranked category: (category id, log-probability) */
+typedef std::pair<int, double> CategoryScore;
+
+/** \class BernoulliModel
+ *  \brief Naive Bayesian scoring for binary attributes on sparse examples.
+ *  For every category the log-probability of the example with all
+ *  attributes absent (baseline) is precomputed, together with the
+ *  change of log-probability when an attribute is present (delta).
+ *  Scoring an example is the baseline plus the deltas of its present
+ *  attributes, so it costs O(present attributes) instead of
+ *  O(all attributes). Deltas are stored attribute-major, one
+ *  contiguous row of categories for each attribute.
+ *  The tables are either owned (build) or external (attach),
+ *  e.g. memory-mapped from a ModelSnapshot. Owned tables can be
+ *  changed one category at a time (online learning).
+ *
+ *  For the top categories (top) an upper bound of the deltas of each
+ *  attribute over all categories is kept, and the categories are
+ *  visited by decreasing baseline. A category is left as soon as its
+ *  partial score plus the bound of the remaining attributes cannot
+ *  enter the top, and the search stops at the first category whose
+ *  baseline plus the bound of all attributes cannot, so with many
+ *  categories most of them are never scored.
+ */
+
+class BernoulliModel {
+    public:
+        BernoulliModel();
+
+        void build(std::size_t attributes, std::size_t categories,
+                   const double* category_log_prob,
+                   const double* value_log_prob,
+                   std::size_t row_size);
+        void attach(std::size_t attributes, std::size_t categories,
+                    const double* baseline, const double* delta);
+        bool setBaselines(const double* baseline);
+        bool setDelta(std::size_t category, const double* delta);
+
+        std::size_t getAttributeCount() const { return _attributes; }
+        std::size_t getCategoryCount() const { return _categories; }
+        const double* getBaseline() const { return _baseline; }
+        const double* getDelta() const { return _delta; }
+
+        void score(const SparseExample& example, double* scores) const;
+        int classify(const SparseExample& example) const;
+        void top(const SparseExample& example, std::size_t k,
+                 std::vector<CategoryScore>& best) const;
+
+    private:
+        BernoulliModel(const BernoulliModel&);              //noncopyable
+        BernoulliModel& operator=(const BernoulliModel&);   //noncopyable
+
+        struct ExampleScore;
+
+        void sortCategories();
+
+        std::size_t _attributes;
+        std::size_t _categories;
+        const double* _baseline;        // [category]
+        const double* _delta;           // [attribute][category]
+        std::vector<double> _storage;   // baseline and delta when owned
+        std::vector<double> _max_delta; // [attribute], not lower than the deltas
+        std::vector<int> _order;        // categories by decreasing baseline
+};
+
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef BAYESIAN_WEBCLASS_BOUNDED_QUEUE_H
+#define BAYESIAN_WEBCLASS_BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/** \class BoundedQueue
+ *  \brief Blocking queue with limited capacity, connecting a producer and a consumer thread.
+ * push waits while the queue is full, pop waits while it is empty,
+ * tryPop does not wait (for consumers running an event loop).
+ * The producer calls close after the last item; pop then returns the
+ * remaining items and false when the queue is drained. The memory
+ * used does not depend on how many items go through the queue.
+ */
+
+template <typename T>
+class BoundedQueue
+{
+    public:
+        explicit BoundedQueue(std::size_t capacity) : _capacity(capacity > 0 ? capacity : 1), _closed(false) {}
+
+        /** \brief Add the item at the end, wait while the queue is full.
+         *  \return false if the queue was closed, the item is dropped then
+         */
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _not_full.wait(lock, [this] { return _closed || _items.size() < _capacity; });
+            if (_closed)
+                return false;
+            _items.push_back(std::move(item));
+            _not_empty.notify_one();
+            return true;
+        }
+
+        /** \brief Take the first item, wait while the queue is empty.
+         *  \return false if the queue is closed and empty
+         */
+        bool pop(T &item) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _not_empty.wait(lock, [this] { return _closed || !_items.empty(); });
+            if (_items.empty())
+                return false;
+            item = std::move(_items.front());
+            _items.pop_front();
+            _not_full.notify_one();
+            return true;
+        }
+
+        /** \brief Take the first item if there is one, without waiting.
+         *  \return false if the queue is empty, see drained
+         */
+        bool tryPop(T &item) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_items.empty())
+                return false;
+            item = std::move(_items.front());
+            _items.pop_front();
+            _not_full.notify_one();
+            return true;
+        }
+
+        /** \brief True if the queue is closed and every item was taken. */
+        bool drained() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _closed && _items.empty();
+        }
+
+        /** \brief No more items will be pushed, waiting threads are woken up. */
+        void close() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+            _not_empty.notify_all();
+            _not_full.notify_all();
+        }
+
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _items.size();
+        }
+
+    private:
+        BoundedQueue(const BoundedQueue &);             //noncopyable
+        BoundedQueue &operator=(const BoundedQueue &);  //noncopyable
+
+        const std::size_t _capacity;
+        bool _closed;
+        std::deque<T> _items;
+        mutable std::mutex _mutex;
+        std::condition_variable _not_empty;
+        std::condition_variable _not_full;
+};
+
+
+#endif //BAYESIAN_WEBCLASS_BOUNDED_QUEUE_H
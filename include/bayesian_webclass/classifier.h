@@ -6,8 +6,15 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
+#include <boost/thread/shared_mutex.hpp>
 #include "faif/learning/NaiveBayesian.hpp"
 #include "faif/learning/Validator.hpp"
+#include "bernoulli_model.h"
+#include "count_table.h"
+#include "multinomial_model.h"
+#include "vocabulary.h"
 
 typedef faif::ml::NaiveBayesian<faif::ValueNominal<std::string>> NBstr;
 typedef faif::ml::NaiveBayesian<faif::ValueNominal<int>> NBint;
@@ -15,6 +22,17 @@ typedef NBint::AttrDomain AttrDomain;
 typedef NBint::Domains Domains;
 typedef NBint::ExampleTest ExampleTest;
 typedef NBint::ExamplesTrain ExamplesTrain;
+typedef faif::ml::NaiveBayesianCompiled<faif::ValueNominal<int>> NBcompiled;
+
+/** \struct BatchResult
+ *  \brief Result of classifying one document of a batch.
+ */
+
+struct BatchResult {
+    std::string category;           // name of the most probable category
+    std::vector<double> beliefs;    // probability of each category, in the
+                                    // order of the categories file
+};
 
 
 /** \class Classifier
@@ -26,23 +44,54 @@ typedef NBint::ExamplesTrain ExamplesTrain;
 
 class Classifier {
     public:
-        void init(std::string attributes,
+        Classifier() {}
+        bool init(std::string attributes,
                   std::string categories,
                   std::string examples_dir,
-                  int examples_num);
+                  int examples_num,
+                  unsigned threads = 0);
         void loadAttributes(std::string attributes);
         void loadCategories(std::string categories);
-        void loadExample(std::string example);
-        std::string classify(std::string example);
+        bool countExamples(const std::string& examples_dir, int first, int last,
+                           CountTable& counts, unsigned threads = 0) const;
+        bool trainFromCounts(const CountTable& counts);
+        bool learn(const std::set<std::string>& attribs, const std::string& category);
+        bool trainMultinomial(const std::string& examples_dir, int first, int last,
+                              MultinomialModel::Variant variant, bool tfidf = false);
+        std::string classify(std::string example) const;
+        std::string classify(const std::set<std::string>& attribs) const;
+        std::vector<CategoryScore> classifyTop(const std::set<std::string>& attribs,
+                                               std::size_t k) const;
+        const std::string& getCategoryName(int id) const;
+        std::vector<BatchResult> classifyBatch(const std::vector<std::string>& documents,
+                                               unsigned threads = 0) const;
+        std::vector<BatchResult> classifyDirectory(const std::string& directory,
+                                                   std::vector<std::string>& files,
+                                                   unsigned threads = 0) const;
+        std::string classifyReference(const std::set<std::string>& attribs) const;
+        bool saveSnapshot(const std::string& filename) const;
+        std::shared_ptr<const Vocabulary> getVocabulary() const;
 
     private:
+        bool readExample(const std::string& example, std::string& buffer,
+                         int& cat, SparseExample& ex) const;
+        double absentLogProbability(int cat) const;
+        void addAttribute(const std::string& word, SparseExample& ex) const;
+        std::string classifyExample(SparseExample& ex) const;
+        void classifyDocument(const std::string& document, BatchResult& result) const;
+
         AttrDomain _cat;
         Domains _attribs;
-        std::map<std::string, int> _attrib_index;
+        std::shared_ptr<Vocabulary> _vocabulary;    // attribute ids
         std::map<std::string, int> _cat_index;
         std::vector<std::string> _cat_list;
-        ExamplesTrain _ex;
-        NBint* _nb;
+        std::unique_ptr<NBint> _nb;
+        std::unique_ptr<NBcompiled> _compiled;
+        BernoulliModel _model;
+        std::vector<double> _absent_log_prob;   // [model category], see learn
+        mutable boost::shared_mutex _model_mutex;   // learn writes _model and _nb, classify methods read
+        std::unique_ptr<MultinomialModel> _multinomial;    // used by classify when trained
+        TfIdf _tfidf;
 };
 
 
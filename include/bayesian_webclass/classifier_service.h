@@ -0,0 +1,54 @@
+#ifndef CLASSIFIER_SERVICE_H
+#define CLASSIFIER_SERVICE_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "classifier.h"
+#include "model_snapshot.h"
+#include "data_preprocessor.h"
+
+/** \class ClassifierService
+ *  \brief Long-lived classification service.
+ *  Trains the classifier once and then classifies en.wikipedia.org
+ *  articles given by url from memory, without spawning a new process
+ *  and retraining the classifier for every query.
+ *  The service can also be started from a ModelSnapshot file,
+ *  then no training is done at all.
+ *  Concurrent calls download with their own HTTPDownloader, taken
+ *  from a pool and sharing one DownloadSession, so a slow download
+ *  does not hold up the other calls.
+ */
+
+class ClassifierService {
+    public:
+        ClassifierService();
+        bool init(const std::string& attributes,
+                  const std::string& categories,
+                  const std::string& examples_dir,
+                  int examples_num);
+        bool load(const std::string& snapshot);
+        bool initOnce(const std::string& snapshot,
+                      const std::string& attributes,
+                      const std::string& categories,
+                      const std::string& examples_dir,
+                      int examples_num);
+        bool isReady() const;
+        bool classify(const std::string& url, std::string& category);
+        bool learn(const std::string& url, const std::string& category);
+
+    private:
+        bool getAttribs(const std::string& url, std::set<std::string>& attribs);
+
+        std::shared_ptr<DownloadSession> _session;  // DNS and TLS sessions of all downloads
+        std::vector<std::unique_ptr<HTTPDownloader>> _downloaders; // idle, reused by the calls
+        std::mutex _downloaders_mutex;
+        std::shared_ptr<Classifier> _classifier;          // changed only by learn,
+        std::shared_ptr<const ModelSnapshot> _snapshot;   // shared with running calls
+        mutable std::mutex _mutex;
+        std::mutex _init_mutex;     // held by initOnce while training
+};
+
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef COUNT_TABLE_H
+#define COUNT_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bernoulli_model.h"
+#include "vocabulary.h"
+
+/** \class CountTable
+ *  \brief Training counters of Naive Bayesian classifier with binary attributes.
+ *  For every category the number of training examples and, for every
+ *  attribute, the number of these examples in which the attribute is
+ *  present. The number of examples with the attribute absent is the
+ *  difference of both. Tables filled independently (e.g. by many
+ *  threads) are combined by merge, the sum of the counters.
+ *  Counters are stored category-major, one contiguous row of
+ *  attributes for each category.
+ *
+ *  The table is saved to a compact binary file (native byte order):
+ *  header, examples [category], then for every category the number
+ *  of non-zero counters and (attribute, count) pairs. Files counted
+ *  on different machines are loaded and merged, and the classifier
+ *  is trained once on the sum, see Classifier::trainFromCounts.
+ *
+ *  The key of the table is a hash of the attribute and category
+ *  names it was counted against (makeKey), kept in the file, so
+ *  tables counted with different attribute or category files of the
+ *  same size are not merged or trained on. Key 0 matches any table.
+ */
+
+class CountTable {
+    public:
+        static const std::uint32_t VERSION = 2;
+
+        CountTable();
+        CountTable(std::size_t categories, std::size_t attributes, std::uint64_t key = 0);
+
+        static std::uint64_t makeKey(const Vocabulary& attributes,
+                                     const std::vector<std::string>& categories);
+
+        void add(int category, const SparseExample& example);
+        bool merge(const CountTable& other);
+        bool save(const std::string& filename) const;
+        bool load(const std::string& filename, std::uint64_t key = 0);
+
+        std::size_t getCategoryCount() const { return _categories; }
+        std::size_t getAttributeCount() const { return _attributes; }
+        std::uint64_t getKey() const { return _key; }
+        int getExamples(int category) const { return _examples[category]; }
+        int getCount(int category, int attribute) const { return _counts[category * _attributes + attribute]; }
+        const int* getCounts(int category) const { return _counts.data() + category * _attributes; }
+
+    private:
+        struct Header;
+
+        std::size_t _categories;
+        std::size_t _attributes;
+        std::uint64_t _key;             // see makeKey, 0 if not known
+        std::vector<int> _examples;     // [category]
+        std::vector<int> _counts;       // [category][attribute]
+};
+
+
+#endif
@@ -5,10 +5,11 @@
 #ifndef BAYESIAN_WEBCLASS_CSV_H
 #define BAYESIAN_WEBCLASS_CSV_H
 
-#include <map>
+#include <functional>
 #include <string>
-#include <boost/tokenizer.hpp>
 #include <bits/unique_ptr.h>
+#include "id_url_map.h"
+#include "csv_reader.h"
 
 /** \class Csv
  *  \brief Class for managing csv files.
@@ -18,8 +19,8 @@
 class Csv
 {
     public:
-        typedef boost::tokenizer<boost::char_separator<char>> t_tokenizer;
-        typedef std::map<int, std::string> map;
+        typedef IdUrlMap map;
+        typedef std::function<bool(int key, CsvReader::view value)> RecordCallback;
     private:
         std::unique_ptr<map> _id_url_map;
         const int _max_invalid_ids; //defaults to 6
@@ -32,6 +33,8 @@ class Csv
 
         bool csv2map(const std::string &filename,
                      const int col1, const int col2);
+        bool readRecords(const std::string &filename, const int col1, const int col2,
+                         const RecordCallback &record) const;
 
         void delete_disabled_urls(map &id_url_map);
         void match_values();
@@ -0,0 +1,48 @@
+#ifndef BAYESIAN_WEBCLASS_CSV_READER_H
+#define BAYESIAN_WEBCLASS_CSV_READER_H
+
+#include <string>
+#include <vector>
+#include <boost/utility/string_view.hpp>
+
+/** \class CsvReader
+ *  \brief Memory-mapped reader of csv files.
+ * The file is mapped into memory and read line by line; fields are
+ * returned as views into the mapping, so no field is copied or allocated.
+ * Line ends and delimiters are found 16 bytes at a time with SSE2
+ * (byte by byte where SSE2 is not available).
+ * Fields are split like boost::char_separator does: empty fields are
+ * dropped, so ";a;;b" has two fields.
+ * Views are valid until the reader is closed or opens another file.
+ */
+
+class CsvReader
+{
+    public:
+        typedef boost::string_view view;
+
+        explicit CsvReader(char delimiter = ';');
+        ~CsvReader();
+
+        bool open(const std::string &filename);
+        void close();
+
+        bool nextLine(view &line);
+        std::size_t split(view line, std::vector<view> &fields,
+                          std::size_t max_fields = std::string::npos) const;
+
+        static const char *find(const char *begin, const char *end, char c);
+        static bool parseInt(view field, int &value);
+
+    private:
+        CsvReader(const CsvReader &);               //noncopyable
+        CsvReader &operator=(const CsvReader &);    //noncopyable
+
+        const char *_data;
+        std::size_t _size;
+        const char *_pos;   //start of the next line
+        char _delimiter;
+};
+
+
+#endif //BAYESIAN_WEBCLASS_CSV_READER_H
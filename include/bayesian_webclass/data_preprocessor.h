@@ -7,6 +7,8 @@
 
 #include "csv.h"
 #include "http_downloader.h"
+#include "async_downloader.h"
+#include "vocabulary.h"
 /** \class DataPreprocessor
  * \brief Class contining data preprocessing tools.
  * Data Preprocessot contains methods to get training and testing
@@ -19,16 +21,29 @@ private:
     std::unique_ptr<Csv> ptr_csv;
     std::string _curl_output_folder;
     int fileCounter;
-    std::set<std::string> all_atribs;
+    std::shared_ptr<Vocabulary> all_atribs; //attributes found by parseHtmls
+    std::shared_ptr<DownloadSession> _session; //connections shared by ptr_http and ptr_async
 public:
+    /** how filterValidDomains decides that a domain is valid */
+    enum FilterMode {
+        DOWNLOAD_PAGES,     //the page can be downloaded, valid domains are saved
+        CHECK_LIVENESS      //the server answers HEAD, every domain is saved with its status and latency
+    };
+
+    std::unique_ptr<PageCache> ptr_cache; //downloaded pages, set by setCache
     std::unique_ptr<HTTPDownloader> ptr_http;
+    std::unique_ptr<AsyncDownloader> ptr_async; //used for downloading many links at once
 
     DataPreprocessor(std::string curl_out_folder = "output");;
-    const std::set<std::string> &getAll_atribs() const;
-    bool filterValidDomains(const std::string &input_file, const std::string &output_file);
+    std::shared_ptr<const Vocabulary> getAll_atribs() const;
+    void setCache(const std::string &directory, long max_age = 24 * 60 * 60);
+    bool filterValidDomains(const std::string &input_file, const std::string &output_file,
+                            FilterMode mode = DOWNLOAD_PAGES, bool keep_order = false);
     bool parseHtmls(const std::string &filename, const std::string &from_which_tags);
     void getAttribs(const std::string &filename);
     bool get_attribs_from_link(const std::string& url);
+    bool get_attribs_from_link(const std::string& url, std::set<std::string>& attribs);
+    static bool get_attribs_from_link(HTTPDownloader &http, const std::string& url, std::set<std::string>& attribs);
     void chooseTrainData(const std::string &filename);
 };
 
@@ -5,21 +5,24 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <map>
+#include <memory>
+#include "vocabulary.h"
 
 /** \class Dictionary
  *  \brief Class for word comparision against a given "dictionary".
  * A simple class for comparing sets of words against the internal
- * list of words.
+ * list of words. The words are kept in a Vocabulary, which can be
+ * shared with the Classifier or DataPreprocessor.
  */
 
 class Dictionary {
     public:
-        Dictionary(){};
+        Dictionary() : word_list(std::make_shared<Vocabulary>()) {};
+        explicit Dictionary(std::shared_ptr<const Vocabulary> words) : word_list(words) {};
         void write_str_to_file(std::string filename, std::string str);
         void fetch_from_file(std::string filename);
         int compare(const std::string& filename);
-        std::vector<std::string> word_list; /**< public internal word list */
+        std::shared_ptr<const Vocabulary> word_list; /**< public internal word list */
 };
 
 
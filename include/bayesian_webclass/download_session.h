@@ -0,0 +1,39 @@
+#ifndef DOWNLOAD_SESSION_H
+#define DOWNLOAD_SESSION_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**\class DownloadSession
+ * \brief Connection state shared by downloaders.
+ * Holds a curl share handle with the DNS cache and TLS sessions, so
+ * requests to the same host (almost always en.wikipedia.org) skip the
+ * lookup and resume the TLS session instead of a full handshake. Open
+ * connections are not shared (curl does not support sharing them between
+ * threads), each downloader keeps its own in its easy or multi handle.
+ * Handles configured by the session negotiate HTTP/2, multiplex transfers
+ * to the same host over one connection and accept every compression
+ * curl supports (gzip, br, ...). The share handle is locked, so one
+ * session can be used by many downloaders in many threads.
+ * The first session initializes libcurl (curl_global_init).
+ */
+class DownloadSession
+{
+public:
+    DownloadSession();
+    virtual ~DownloadSession();
+
+    void configure(void *easy, const std::string &url = std::string()) const;
+    void configureMulti(void *multi) const;
+
+private:
+    DownloadSession(const DownloadSession &);               //noncopyable
+    DownloadSession &operator=(const DownloadSession &);    //noncopyable
+
+    void *_share;
+    std::unique_ptr<std::mutex[]> _locks;   //one per kind of shared data
+};
+
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef FNV_HASH_H
+#define FNV_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+/** \brief Initial value of the 64 bit FNV-1a hash (offset basis).
+ */
+
+const std::uint64_t FNV1A_BASIS = 14695981039346656037ULL;
+
+/** \brief 64 bit FNV-1a hash, used for the vocabulary table, the count table key and the page cache file names.
+ *  The hash of a sequence of bytes is continued by passing it as
+ *  the initial value of the next call.
+ *  @param data hashed bytes
+ *  @param size number of bytes
+ *  @param hash hash of the bytes before, FNV1A_BASIS to start
+ *  @return hash of the bytes before followed by data
+ */
+
+inline std::uint64_t fnv1a(const char* data, std::size_t size,
+                           std::uint64_t hash = FNV1A_BASIS) {
+    for(std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+#endif
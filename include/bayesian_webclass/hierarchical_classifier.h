@@ -0,0 +1,70 @@
+#ifndef HIERARCHICAL_CLASSIFIER_H
+#define HIERARCHICAL_CLASSIFIER_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "bernoulli_model.h"
+#include "count_table.h"
+#include "vocabulary.h"
+
+/** \class HierarchicalClassifier
+ *  \brief Naive Bayesian classifier descending a tree of categories.
+ *  The categories are organised in a tree, read from a file with one
+ *  "parent child" pair of names per line, e.g.
+ *  Relativity Gravitation, Gravitation Gravitational_waves,
+ *  Gravitational_waves Gravitational-wave_astronomy. Names which are
+ *  not categories group their children; categories missing from the
+ *  file and nodes without a parent hang from an implicit root, so an
+ *  empty file gives the flat classifier.
+ *
+ *  Every node with more than one branch (its children and, when the
+ *  node is a category itself, stopping at the node) has its own
+ *  BernoulliModel trained on the counters of the categories below
+ *  each branch. Classification descends from the root keeping the
+ *  beam best paths, scored by the sum of log-probabilities of the
+ *  branches taken; a beam of 1 is the greedy descent. A document is
+ *  scored against depth * branching categories instead of all of them.
+ */
+
+class HierarchicalClassifier {
+    public:
+        HierarchicalClassifier();
+
+        bool init(const std::string& attributes,
+                  const std::string& categories,
+                  const std::string& tree,
+                  const std::string& examples_dir,
+                  int examples_num,
+                  unsigned threads = 0);
+        bool loadTree(const std::string& tree, const std::vector<std::string>& categories);
+        bool train(std::shared_ptr<const Vocabulary> vocabulary, const CountTable& counts);
+
+        std::string classify(const std::set<std::string>& attribs, std::size_t beam = 1) const;
+        std::size_t getNodeCount() const { return _nodes.size(); }
+        std::size_t getDepth() const;
+
+    private:
+        struct Node {
+            std::string name;
+            int category;                   // index in the categories, -1 for groups
+            int parent;                     // -1 for the root
+            std::vector<int> children;
+            std::vector<int> branches;      // [model category], child or the node itself
+            std::unique_ptr<BernoulliModel> model;  // when there are many branches
+        };
+
+        int addNode(const std::string& name);
+        void subtreeCategories(int node, std::vector<int>& categories) const;
+
+        std::vector<Node> _nodes;           // the root first
+        std::map<std::string, int> _index;  // node of a name
+        std::vector<std::string> _categories;
+        std::shared_ptr<const Vocabulary> _vocabulary;
+};
+
+
+#endif
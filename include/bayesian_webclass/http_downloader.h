@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <memory>
+#include "page_cache.h"
+#include "download_session.h"
 
 /**\class HTTPDownloader
  * \brief Class for downloading and cleaning html code
@@ -13,24 +16,27 @@
 class HTTPDownloader
 {
 public:
-	HTTPDownloader();
+	explicit HTTPDownloader(std::shared_ptr<DownloadSession> session = std::shared_ptr<DownloadSession>());
 	virtual ~HTTPDownloader();
     void writeStrToFile(const std::string &filename, const std::string &str);
 	void writeSetToFile(const std::string &filename, const std::set<std::string> &set);
     
     bool download(const std::string& url, std::string& output); //downloads html text from given url
+    void setCache(const PageCache *cache); //pages are taken from and saved to the cache, nullptr - no cache
 	bool check_link(const std::string& url);
 
 
-	std::string cleanhtml(const std::string &html); //makes html tidy, brackets are closed and  that html code is ready to be parsed
+	static std::string cleanhtml(const std::string &html); //makes html tidy, brackets are closed and  that html code is ready to be parsed
 
 	std::vector<std::string> getLinesFromFile(std::string filename); //gets list of html addresses from given file in every line should be one http_address
-	int parseHtmlAndSave(const std::string &htmlText, const std::string &nodeOfHtmlTree, std::string &output,
-						 std::set<std::string> &uniqueAttributes); //parse html_text and save to file only the text from given node_of_html_tree
+	static int parseHtmlAndSave(const std::string &htmlText, const std::string &nodeOfHtmlTree, std::string &output,
+								std::set<std::string> &uniqueAttributes); //parse html_text and save to file only the text from given node_of_html_tree
 
 
 private:
     void* curl;
+    const PageCache *_cache;
+    std::shared_ptr<DownloadSession> _session;
 };
 
 
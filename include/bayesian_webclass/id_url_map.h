@@ -0,0 +1,70 @@
+#ifndef BAYESIAN_WEBCLASS_ID_URL_MAP_H
+#define BAYESIAN_WEBCLASS_ID_URL_MAP_H
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/utility/string_view.hpp>
+
+/** \class IdUrlMap
+ *  \brief Compact map id -> url.
+ * Ids are kept in a sorted array, urls one after another in a single
+ * string arena, with an array of offsets into it. There is no allocation
+ * per entry, lookup is a binary search and iteration goes through
+ * contiguous memory in the order of ids, like std::map.
+ * Entries are added at the end and ordered by sort(); for a repeated id
+ * the entry added first is kept, as std::map::insert does.
+ */
+
+class IdUrlMap
+{
+    public:
+        typedef boost::string_view view;
+        typedef std::pair<int, view> value_type;
+
+        /** \brief Iterator over (id, url) pairs in the order of ids */
+        class const_iterator : public std::iterator<std::forward_iterator_tag, value_type>
+        {
+            public:
+                const_iterator() : _map(nullptr), _index(0) {}
+                const_iterator(const IdUrlMap *map, std::size_t index) : _map(map), _index(index) {}
+
+                const value_type &operator*() const { _value = _map->at(_index); return _value; }
+                const value_type *operator->() const { return &**this; }
+                const_iterator &operator++() { ++_index; return *this; }
+                const_iterator operator++(int) { const_iterator it(*this); ++_index; return it; }
+                bool operator==(const const_iterator &other) const { return _index == other._index; }
+                bool operator!=(const const_iterator &other) const { return _index != other._index; }
+
+            private:
+                const IdUrlMap *_map;
+                std::size_t _index;
+                mutable value_type _value;
+        };
+        typedef const_iterator iterator;
+
+        IdUrlMap();
+
+        void add(int id, view url);
+        void sort();
+        void clear();
+
+        std::size_t size() const;
+        bool empty() const;
+        value_type at(std::size_t index) const;
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_iterator find(int id) const;
+        std::size_t count(int id) const;
+
+    private:
+        std::vector<int> _ids;
+        std::vector<std::size_t> _offsets;  //url i is arena[offsets[i], offsets[i + 1])
+        std::string _arena;
+        bool _sorted;
+};
+
+
+#endif //BAYESIAN_WEBCLASS_ID_URL_MAP_H
@@ -0,0 +1,100 @@
+#ifndef BAYESIAN_WEBCLASS_LINK_EXTRACTOR_H
+#define BAYESIAN_WEBCLASS_LINK_EXTRACTOR_H
+
+#include <string>
+#include <set>
+#include <vector>
+
+/** \class LinkPathTracker
+ * \brief Tracks the element path of a document and collects /wiki/ links.
+ * Gets start and end element events from any event source (SAX parser,
+ * tokenizer) and keeps only the length of the matched prefix of the path,
+ * so memory does not depend on the size of the document.
+ * Links are collected from <a href> elements inside the elements
+ * matching the path, as HTTPDownloader::parseHtmlAndSave does.
+ *
+ * Supported path: absolute, steps separated by '/', every step is an element
+ * name or '*', optionally with one [@id='value'] predicate, e.g.
+ * "/html/body/div[@id='content']/p".
+ */
+class LinkPathTracker {
+public:
+    /** \brief One step of the path */
+    struct Step {
+        std::string name;   //element name, "*" for any element
+        std::string id;     //required id, empty for any
+        bool has_id;
+    };
+
+    LinkPathTracker(const std::vector<Step> &steps, std::set<std::string> &links);
+
+    void startElement(const char *name, const char *id, const char *href);
+    void endElement();
+
+    static bool parsePath(const std::string &path, std::vector<Step> &steps);
+    static bool toAttribute(const char *href, std::string &attribute);
+
+private:
+    const std::vector<Step> &_steps;
+    std::set<std::string> &_links;
+    std::size_t _depth;     //number of open elements
+    std::size_t _matched;   //number of open elements matching the first steps of the path
+};
+
+/** \class HtmlEventSource
+ * \brief Source of element events for LinkPathTracker.
+ * Different html parsers can be plugged into LinkExtractor,
+ * e.g. a fast tokenizer with a tolerant parser as a fallback.
+ */
+class HtmlEventSource {
+public:
+    virtual ~HtmlEventSource() {}
+    /** parse the html and send its elements to the tracker, false if the html cannot be handled */
+    virtual bool parse(const std::string &html, LinkPathTracker &tracker) const = 0;
+};
+
+/** \class SaxEventSource
+ * \brief Events from the libxml2 HTML push parser.
+ * The html code is fed to the parser in chunks and only SAX events are
+ * used, no document tree is built. Never fails, broken html is recovered.
+ */
+class SaxEventSource : public HtmlEventSource {
+public:
+    SaxEventSource();
+    virtual bool parse(const std::string &html, LinkPathTracker &tracker) const;
+};
+
+/** \class TokenizerEventSource
+ * \brief Events from a fast, lenient html tokenizer.
+ * Scans the tags in one pass without building any tree. End tags close
+ * the nearest open element with the same name, void elements close
+ * themselves and a new paragraph or block closes an open <p>, which is
+ * enough for article pages. Fails on pages it cannot follow: unterminated
+ * tags or comments or too deep nesting. A page without the path is parsed
+ * successfully and has no links, it is not parsed again by the fallback.
+ */
+class TokenizerEventSource : public HtmlEventSource {
+public:
+    virtual bool parse(const std::string &html, LinkPathTracker &tracker) const;
+};
+
+/** \class LinkExtractor
+ * \brief Streaming extraction of /wiki/ links.
+ * Links are collected by LinkPathTracker from the events of the given
+ * HtmlEventSource, SaxEventSource by default. The extractor is read-only
+ * after construction and can be used from many threads at once.
+ */
+class LinkExtractor {
+public:
+    explicit LinkExtractor(const std::string &path);
+
+    bool isValid() const;
+    int extract(const std::string &html, std::set<std::string> &links) const;
+    bool extract(const std::string &html, std::set<std::string> &links, const HtmlEventSource &source) const;
+
+private:
+    std::vector<LinkPathTracker::Step> _steps;
+    bool _valid;
+};
+
+#endif //BAYESIAN_WEBCLASS_LINK_EXTRACTOR_H
@@ -0,0 +1,69 @@
+#ifndef MODEL_SNAPSHOT_H
+#define MODEL_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <set>
+#include "bernoulli_model.h"
+
+/** \class ModelSnapshot
+ *  \brief Compact binary file with a trained classifier.
+ *  The snapshot holds the attribute dictionary, the category list
+ *  and the log-probability tables (BernoulliModel baseline and
+ *  deltas) of a trained Naive Bayesian classifier with binary
+ *  attributes. It is written once after training and memory-mapped
+ *  on load, so a new process can classify without reading and
+ *  training on the example files.
+ *
+ *  File layout (native byte order, sections aligned to 8 bytes):
+ *  header, attribute name offsets, category name offsets,
+ *  attribute ids sorted by name, string arena,
+ *  baseline log-probabilities [category],
+ *  present attribute deltas [attribute][category].
+ */
+
+class ModelSnapshot {
+    public:
+        static const std::uint32_t VERSION = 2;
+
+        ModelSnapshot();
+        ~ModelSnapshot();
+
+        static bool write(const std::string& filename,
+                          const std::vector<std::string>& attributes,
+                          const std::vector<std::string>& categories,
+                          const BernoulliModel& model);
+
+        bool open(const std::string& filename);
+        void close();
+        bool isOpen() const;
+
+        std::size_t getAttributeCount() const;
+        std::size_t getCategoryCount() const;
+        std::string getCategory(std::size_t index) const;
+        int findAttribute(const std::string& word) const;
+        const BernoulliModel& getModel() const;
+        std::string classify(const std::set<std::string>& attribs) const;
+
+    private:
+        struct Header;
+
+        ModelSnapshot(const ModelSnapshot&);                //noncopyable
+        ModelSnapshot& operator=(const ModelSnapshot&);     //noncopyable
+
+        std::string getName(const std::uint32_t* offsets, std::size_t index) const;
+
+        const char* _data;
+        std::size_t _size;
+        const Header* _header;
+        const std::uint32_t* _attrib_names;
+        const std::uint32_t* _cat_names;
+        const std::uint32_t* _attrib_order;
+        const char* _strings;
+        BernoulliModel _model;
+};
+
+
+#endif
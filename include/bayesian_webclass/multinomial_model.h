@@ -0,0 +1,52 @@
+#ifndef MULTINOMIAL_MODEL_H
+#define MULTINOMIAL_MODEL_H
+
+#include <cstddef>
+#include <vector>
+#include "tf_idf.h"
+
+/** \class MultinomialModel
+ *  \brief Multinomial and complement Naive Bayesian scoring on term vectors.
+ *  Every (term, category) pair has a single float weight, the smoothed
+ *  log-probability of the term in the category (multinomial) or minus
+ *  the log-probability of the term in all other categories (complement,
+ *  better for unbalanced categories). The score of a document is the
+ *  category log-prior plus the sparse dot product of its term weights
+ *  (counts or TF-IDF) with the weights of the category, so only the
+ *  terms of the document are read. Weights are stored term-major, one
+ *  contiguous row of categories for each term.
+ */
+
+class MultinomialModel {
+    public:
+        enum Variant {
+            MULTINOMIAL,
+            COMPLEMENT
+        };
+
+        MultinomialModel();
+
+        void train(std::size_t terms, std::size_t categories,
+                   const std::vector<TermVector>& documents,
+                   const std::vector<int>& labels,
+                   Variant variant, double alpha = 1.0);
+
+        std::size_t getTermCount() const { return _terms; }
+        std::size_t getCategoryCount() const { return _categories; }
+        Variant getVariant() const { return _variant; }
+        float getWeight(int term, int category) const { return _weights[term * _categories + category]; }
+        float getBias(int category) const { return _bias[category]; }
+
+        void score(const TermVector& document, double* scores) const;
+        int classify(const TermVector& document) const;
+
+    private:
+        std::size_t _terms;
+        std::size_t _categories;
+        Variant _variant;
+        std::vector<float> _bias;       // [category], log-prior
+        std::vector<float> _weights;    // [term][category]
+};
+
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef BAYESIAN_WEBCLASS_PAGE_CACHE_H
+#define BAYESIAN_WEBCLASS_PAGE_CACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+/** \class PageCache
+ * \brief On-disk cache of downloaded pages.
+ * Every page is kept in its own file named by the FNV-1a hash of the
+ * normalised url, with the zlib compressed body and the ETag and
+ * Last-Modified headers of the response. A fresh page is served from
+ * disk, a stale one is revalidated with a conditional request
+ * (If-None-Match / If-Modified-Since). Files are written to a temporary
+ * name and renamed, so many processes and threads can share the directory.
+ */
+class PageCache {
+public:
+    /** \brief Cached page */
+    struct Entry {
+        std::string url;            //normalised url
+        std::string body;
+        std::string etag;
+        std::string last_modified;
+        std::time_t time;           //when the page was downloaded or revalidated
+    };
+
+    /** \brief ETag and Last-Modified of a response */
+    struct ResponseHeaders {
+        std::string etag;
+        std::string last_modified;
+    };
+
+    explicit PageCache(const std::string &directory, long max_age = 24 * 60 * 60);
+
+    bool lookup(const std::string &url, Entry &entry) const;
+    bool isFresh(const Entry &entry) const;
+    bool store(const std::string &url, const char *body, std::size_t size,
+               const std::string &etag, const std::string &last_modified) const;
+
+    bool finishResponse(const std::string &url, const Entry *cached, bool success, long status,
+                        std::string &body, const std::string &etag, const std::string &last_modified) const;
+
+    static std::vector<std::string> conditionalHeaders(const Entry &entry);
+    static void parseHeader(const char *line, std::size_t size, std::string &etag, std::string &last_modified);
+    static std::size_t headerCallback(char *line, std::size_t size, std::size_t nmemb, void *headers);
+    static std::string normaliseUrl(const std::string &url);
+    static std::uint64_t hash(const std::string &str);
+
+private:
+    std::string getFilename(const std::string &normalised_url) const;
+
+    std::string _directory;
+    long _max_age;  //seconds, negative - pages never get stale
+};
+
+#endif //BAYESIAN_WEBCLASS_PAGE_CACHE_H
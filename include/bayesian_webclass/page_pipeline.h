@@ -0,0 +1,82 @@
+#ifndef BAYESIAN_WEBCLASS_PAGE_PIPELINE_H
+#define BAYESIAN_WEBCLASS_PAGE_PIPELINE_H
+
+#include <string>
+#include <set>
+#include <vector>
+#include <memory>
+#include "link_extractor.h"
+
+/** \struct Page
+ * \brief Downloaded page passed through the PagePipeline.
+ * Everything is kept in memory, stages change the page in place.
+ */
+struct Page {
+    std::string url;
+    std::string html;               //downloaded html code
+    std::set<std::string> attribs;  //links found in the article
+};
+
+/** \class PageStage
+ * \brief One step of page processing (cleaning, parsing, extracting).
+ * Stages keep no state between pages, so one stage can process
+ * many pages at once from different threads.
+ */
+class PageStage {
+public:
+    virtual ~PageStage() {}
+    virtual bool process(Page &page) const = 0; //false stops processing of the page
+};
+
+/** \class PreparePageStage
+ * \brief Joins lines of html code until every line ends with a closing '>'.
+ * Works in place on the downloaded html.
+ */
+class PreparePageStage : public PageStage {
+public:
+    virtual bool process(Page &page) const;
+};
+
+/** \class TidyEventSource
+ * \brief Cleans the html with libtidy (HTTPDownloader::cleanhtml) and parses it with SaxEventSource.
+ * Slow, used as a fallback for pages the fast tokenizer cannot follow.
+ */
+class TidyEventSource : public HtmlEventSource {
+public:
+    virtual bool parse(const std::string &html, LinkPathTracker &tracker) const;
+};
+
+/** \class ExtractLinksStage
+ * \brief Extracts /wiki/ links from the given part of html code into Page::attribs.
+ * Uses the streaming LinkExtractor with the added html event sources,
+ * tried in the order of adding until one succeeds. SaxEventSource is
+ * used when there are no sources or all of them failed. Paths the
+ * extractor cannot track are parsed with HTTPDownloader::parseHtmlAndSave.
+ */
+class ExtractLinksStage : public PageStage {
+public:
+    explicit ExtractLinksStage(const std::string &from_which_tags);
+    ExtractLinksStage &addSource(HtmlEventSource *source);
+    virtual bool process(Page &page) const;
+private:
+    std::string _from_which_tags;
+    LinkExtractor _extractor;
+    std::vector<std::unique_ptr<HtmlEventSource>> _sources;
+};
+
+/** \class PagePipeline
+ * \brief Sequence of stages run on every page.
+ * A page goes through all stages in the order they were added,
+ * no temporary files are used, so pages can be processed concurrently.
+ */
+class PagePipeline {
+public:
+    PagePipeline &add(PageStage *stage);
+    bool process(Page &page) const;
+
+    static PagePipeline createLinkPipeline(const std::string &from_which_tags);
+private:
+    std::vector<std::unique_ptr<PageStage>> _stages;
+};
+
+#endif //BAYESIAN_WEBCLASS_PAGE_PIPELINE_H
@@ -0,0 +1,37 @@
+#ifndef TF_IDF_H
+#define TF_IDF_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/** term vector: sorted (term id, weight) pairs, the weight is the
+ *  number of occurrences of the term before weighting */
+typedef std::vector<std::pair<int, float> > TermVector;
+
+/** \class TfIdf
+ *  \brief TF-IDF weighting of term vectors.
+ *  The inverse document frequency of every term is learned from the
+ *  training documents (fit), then the weight of a term in a document
+ *  is log(1 + count) * idf, and the document is scaled to unit
+ *  length, so long articles do not dominate the counts.
+ */
+
+class TfIdf {
+    public:
+        TfIdf();
+
+        void fit(const std::vector<TermVector>& documents, std::size_t terms);
+        void apply(TermVector& document) const;
+
+        bool empty() const { return _idf.empty(); }
+        float getIdf(int term) const { return _idf[term]; }
+
+        static TermVector toTerms(std::vector<int>& ids);
+
+    private:
+        std::vector<float> _idf;    // [term]
+};
+
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef VOCABULARY_H
+#define VOCABULARY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/utility/string_view.hpp>
+
+/** \class Vocabulary
+ *  \brief Interned set of words (attributes) with dense ids.
+ *  Words are stored one after another in a single string arena and
+ *  get ids 0, 1, 2, ... in the order they are added. A word is found
+ *  by one probe sequence in an open-addressing hash table (FNV-1a,
+ *  linear probing, at most half full) holding the ids, so looking up
+ *  a token costs one hash and usually one string comparison.
+ *  Lookups are const and can run from many threads at once.
+ */
+
+class Vocabulary {
+    public:
+        typedef boost::string_view view;
+
+        Vocabulary();
+
+        int add(view word);
+        int find(view word) const;
+        view getWord(int id) const;
+        std::size_t size() const;
+        bool empty() const;
+        void clear();
+
+        bool load(const std::string& filename);
+        bool save(const std::string& filename) const;
+        std::vector<std::string> getWords() const;
+
+        static std::uint64_t hash(view word);
+
+    private:
+        void rehash(std::size_t slots);
+        std::size_t findSlot(view word, std::uint64_t h) const;
+
+        std::string _arena;
+        std::vector<std::uint32_t> _offsets;    // word i is _arena[_offsets[i], _offsets[i + 1])
+        std::vector<std::uint64_t> _hashes;     // hash of every word, for rehashing
+        std::vector<std::int32_t> _slots;       // ids, -1 for an empty slot
+};
+
+
+#endif
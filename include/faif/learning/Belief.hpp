@@ -1,6 +1,9 @@
 #ifndef FAIF_BELIEF_HPP_
 #define FAIF_BELIEF_HPP_
 
+#include <cmath>
+#include <cstddef>
+#include <limits>
 #include <ostream>
 
 #include <boost/serialization/serialization.hpp>
@@ -84,6 +87,34 @@ namespace faif {
             Probability probability_;        //public member
         };
 
+        /** \brief change the log-probabilities into probabilities summing to 1 (softmax), in place
+
+            The stable log-sum-exp: the maximum is subtracted before exp, so the log-probabilities of long examples
+            (thousands of attributes) do not underflow to 0/0. One pass for the maximum, one std::exp per value
+            and one scaling pass over a contiguous table. Returns the log-sum-exp of the given log-probabilities.
+        */
+        inline Probability normalizeLogProbabilities(Probability* p, std::size_t n) {
+            if( n == 0 )
+                return -std::numeric_limits<Probability>::infinity();
+            Probability max = p[0];
+            for(std::size_t i = 1; i < n; ++i)
+                max = p[i] > max ? p[i] : max;
+            if( !(max > -std::numeric_limits<Probability>::infinity()) ) { //all impossible, keep uniform
+                for(std::size_t i = 0; i < n; ++i)
+                    p[i] = 1.0 / n;
+                return max;
+            }
+            Probability sum = 0.0;
+            for(std::size_t i = 0; i < n; ++i) {
+                p[i] = std::exp(p[i] - max);
+                sum += p[i];
+            }
+            const Probability scale = 1.0 / sum;
+            for(std::size_t i = 0; i < n; ++i)
+                p[i] *= scale;
+            return max + std::log(sum);
+        }
+
         //ostream iterator for debugging
         template <typename Val> std::ostream& operator<<(std::ostream& os, const Belief<Val>& b) {
             os << "Value:" << b.getValue() << " Prob:" << b.getProbability();
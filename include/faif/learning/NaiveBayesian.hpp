@@ -12,18 +12,60 @@
 #include <string>
 #include <memory>
 #include <algorithm>
+#include <vector>
+#include <limits>
+#include <cmath>
 
 #include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/map.hpp>
+#include <boost/serialization/traits.hpp>
 
 #include "Classifier.hpp"
+#include "TopCategories.hpp"
 
 namespace faif {
     namespace ml {
 
+        /** \brief the exception thrown when the frozen classifier would be changed */
+        class ModelFrozenException : public FaifException {
+        public:
+            ModelFrozenException() {}
+            virtual ~ModelFrozenException() throw() {}
+            virtual const char *what() const throw() { return "ModelFrozenException"; }
+            virtual std::ostream& print(std::ostream& os) const throw() {
+                os << "The classifier is frozen, it cannot be trained or reset";
+                return os;
+            }
+        };
+
+        /** \brief the exception thrown when the classifier loaded without the counters would learn online */
+        class ModelWithoutCountersException : public FaifException {
+        public:
+            ModelWithoutCountersException() {}
+            virtual ~ModelWithoutCountersException() throw() {}
+            virtual const char *what() const throw() { return "ModelWithoutCountersException"; }
+            virtual std::ostream& print(std::ostream& os) const throw() {
+                os << "The classifier was loaded without the counters (version 0), reset and train it again";
+                return os;
+            }
+        };
+
+        /** \brief the exception thrown when the probabilities are read from the classifier in training state */
+        class ModelNotFrozenException : public FaifException {
+        public:
+            ModelNotFrozenException() {}
+            virtual ~ModelNotFrozenException() throw() {}
+            virtual const char *what() const throw() { return "ModelNotFrozenException"; }
+            virtual std::ostream& print(std::ostream& os) const throw() {
+                os << "The classifier is in training state, call freeze or switchClassify before reading the probabilities";
+                return os;
+            }
+        };
+
         /** \brief Naive Bayesian Classifier.
 
             Contains the attributes, attribute values and categories,
@@ -41,12 +83,14 @@ namespace faif {
             typedef typename Classifier<Val>::ExampleTest ExampleTest;
             typedef typename Classifier<Val>::ExampleTrain ExampleTrain;
             typedef typename Classifier<Val>::ExamplesTrain ExamplesTrain;
+            /** \brief the attribute values and the number of training examples they occur in */
+            typedef std::vector<std::pair<AttrIdd, int> > ValueCounters;
         public:
             NaiveBayesian();
             NaiveBayesian(const Domains& attr_domains, const AttrDomain& category_domain);
             virtual ~NaiveBayesian() { }
 
-            /** the clear the learned parameters */
+            /** the clear the learned parameters, throws ModelFrozenException if frozen */
             virtual void reset();
 
             /** \brief learn classifier (on the collection of training examples) */
@@ -60,9 +104,50 @@ namespace faif {
             /** \brief classify and return all classes with belief that the example is from given class */
             virtual Beliefs getCategories(const ExampleTest&) const;
 
-            /** incremental learn - add training example  */
+            /** \brief incremental learn - add training example, throws ModelFrozenException if frozen
+                (and ModelWithoutCountersException if loaded from an archive without the counters)
+
+                In classify state (see switchClassify) the learned counters are kept, only the log-probabilities
+                of the example category (and the category priors) are updated, in O(example values),
+                and the classifier keeps classifying.
+            */
             void trainIncremental(const ExampleTrain&);
 
+            /** \brief learn from counters instead of examples, throws ModelFrozenException if frozen
+
+                Adds cat_count training examples of category cat_val, each value occurs in the given number of them.
+                The same as trainIncremental called for each of the examples, so the counters collected elsewhere
+                (e.g. by many threads) can be added at once.
+            */
+            void addCounters(AttrIdd cat_val, int cat_count, const ValueCounters& value_counters);
+
+            /** \brief finish the training, switch to classify state for good.
+
+                After freeze the const methods do not change the internal state,
+                so the classifier can be shared between threads without locking.
+                Training, reset and load throw ModelFrozenException.
+            */
+            void freeze();
+
+            /** \brief switch to classify state for online learning, throws ModelFrozenException if frozen
+
+                As freeze, the probabilities are calculated and the const methods do not change the internal
+                state, but trainIncremental and addCounters still update it (online learning). The caller has
+                to serialize them with the reads, e.g. by a readers-writer lock.
+            */
+            void switchClassify();
+
+            /** true if freeze was called */
+            bool isFrozen() const { return frozen_; }
+
+            /** the log-probability of given category (calculated from training examples),
+                throws ModelNotFrozenException in training state (the const methods do not switch the state) */
+            Probability getCategoryLogProbability(AttrIdd cat_val) const;
+
+            /** the log-probability of given attribute value in given category, throws ModelNotFrozenException
+                in training state */
+            Probability getValueLogProbability(AttrIdd cat_val, AttrIdd value) const;
+
             /** the ostream method */
             virtual void write(std::ostream& os) const;
 
@@ -99,8 +184,14 @@ namespace faif {
 
             //forward declaration
             class NaiveBayesianTraining;
+            class NaiveBayesianClasify;
+
+            /** the classify state, throws ModelNotFrozenException in training state */
+            const NaiveBayesianClasify& classifyState() const;
 
             std::auto_ptr<NaiveBayesianTraining> impl_;
+            /** the classify state is final, see freeze */
+            bool frozen_;
 
             /** \brief internal class to connect category and counter or probability
 
@@ -176,6 +267,9 @@ namespace faif {
                 /** adds the training example, actualize counters */
                 virtual void addTraining(const ExampleTrain& example);
 
+                /** adds the counters of many training examples of given category */
+                virtual void addCounters(AttrIdd cat_val, int cat_count, const ValueCounters& value_counters);
+
                 /** classifies the given example. Here the re-load of classifier type and re-calling the method */
                 virtual AttrIdd getCategory(const ExampleTest& example) {
                     return parent_->switchGetCategory(example);
@@ -211,6 +305,8 @@ namespace faif {
                 }
 
             private:
+                /** the classify state keeps the counters for online learning */
+                friend class NaiveBayesianClasify;
                 /** the counters - for each category each non-zero occurence of attribute */
                 CategoryCounters counters_;
                 /** noncopyable */
@@ -220,27 +316,44 @@ namespace faif {
             };
 
 
-            /** inner class - the classify state of Naive Bayesian Classifier */
-            class NaiveBayesianClasify : public NaiveBayesianTraining {
+            /** \brief inner class - the classify state of Naive Bayesian Classifier
+
+                The counters of the training state are kept. The log-probabilities are stored split into
+                the numerators (log of counter + 1) and the denominators (log of counters sum with Laplace smoothing),
+                so the new training example changes only the numerators of its values and the denominators of its category.
+                Serialization version 1 stores the counters; version 0 (the log-probabilities only) is still loaded,
+                such classifier has no counters and the training throws ModelWithoutCountersException.
+            */
+            class NaiveBayesianClasify : public NaiveBayesianTraining,
+                                         public boost::serialization::traits<NaiveBayesianClasify,
+                                                                             boost::serialization::object_class_info,
+                                                                             boost::serialization::track_selectively,
+                                                                             1> {
             public:
                 typedef typename CategoryData<Probability>::AttrData Counters;
 
                 typedef std::map<AttrIdd, CategoryData<Probability> > InternalProbabilities;
 
+                /** for each category: log(value domain size + category counter), indexed by the domain size */
+                typedef std::map<AttrIdd, std::vector<Probability> > Denominators;
+
                 //for load/save
-                NaiveBayesianClasify() {}
+                NaiveBayesianClasify() : sumTraining_(0), categoryDenominator_(0.0), maxValSize_(0), hasCounters_(true) {}
 
-                NaiveBayesianClasify(NaiveBayesian& parent, const NaiveBayesianTraining& nb_train) : NaiveBayesianTraining(parent) {
+                NaiveBayesianClasify(NaiveBayesian& parent, const NaiveBayesianTraining& nb_train)
+                    : NaiveBayesianTraining(parent), sumTraining_(0), categoryDenominator_(0.0), maxValSize_(0),
+                      hasCounters_(true) {
                     //calculate probabilities
                     calculate(nb_train);
                 }
 
                 virtual ~NaiveBayesianClasify() {}
 
-                /** adds the training example */
-                virtual void addTraining(const ExampleTrain& example) {
-                    this->parent_->switchAddTraining(example);
-                }
+                /** adds the training example, updates the probabilities of its category (online learning) */
+                virtual void addTraining(const ExampleTrain& example);
+
+                /** adds the counters, updates the probabilities of the category (online learning) */
+                virtual void addCounters(AttrIdd cat_val, int cat_count, const ValueCounters& value_counters);
 
                 /** classifies the given example. Using Naive Bayesian approach */
                 virtual AttrIdd getCategory(const ExampleTest& example);
@@ -272,17 +385,35 @@ namespace faif {
                 void save(Archive & ar, const unsigned int /* file_version */) const;
 
                 template<class Archive>
-                void load(Archive & ar, const unsigned int /* file_version */);
+                void load(Archive & ar, const unsigned int file_version);
+
+                template<class Archive>
+                void loadProbabilities(Archive & ar);
 
                 template<class Archive>
                 void serialize( Archive &ar, const unsigned int file_version ){
                     boost::serialization::split_member(ar, *this, file_version);
                 }
             private:
-                /** the internal probabilities */
+                /** the numerators of the probabilities, log(counter + 1) */
                 InternalProbabilities probabl_;
+                /** the denominators of the attribute value probabilities */
+                Denominators denominators_;
+                /** the number of training examples */
+                int sumTraining_;
+                /** the denominator of the category probabilities, log(categories + training examples) */
+                Probability categoryDenominator_;
+                /** the size of the largest attribute domain */
+                int maxValSize_;
+                /** false if loaded from version 0, without the counters, then the training throws */
+                bool hasCounters_;
                 /** calculate the probabilities */
                 void calculate(const NaiveBayesianTraining& nb_train);
+                /** update the numerators of the category and given values, and the denominators, after the counters changed */
+                template<typename It>
+                void update(AttrIdd cat_val, int added, It values_begin, It values_end);
+                /** calculate the denominators for given category */
+                void calcDenominators(AttrIdd cat_val);
                 /** calculate log-probability for given example and category */
                 Probability calcProbabilityForExample(const ExampleTest& example, AttrIdd cat_val) const;
 
@@ -300,14 +431,14 @@ namespace faif {
         //////////////////////////////////////////////////////////////////////////////////////////////////
 
         template<typename Val>
-        NaiveBayesian<Val>::NaiveBayesian() : Classifier<Val>()
+        NaiveBayesian<Val>::NaiveBayesian() : Classifier<Val>(), frozen_(false)
         {
             impl_.reset( new NaiveBayesianTraining(*this) );
         }
 
         template<typename Val>
         NaiveBayesian<Val>::NaiveBayesian(const Domains& attr_domains, const AttrDomain& category_domain)
-            : Classifier<Val>(attr_domains, category_domain)
+            : Classifier<Val>(attr_domains, category_domain), frozen_(false)
         {
             impl_.reset( new NaiveBayesianTraining(*this) );
         }
@@ -315,6 +446,8 @@ namespace faif {
         /** the clear the learned parameters */
         template<typename Val>
         void NaiveBayesian<Val>::reset() {
+            if( frozen_ )
+                throw ModelFrozenException();
             impl_.reset( new NaiveBayesianTraining(*this) );
         }
 
@@ -335,9 +468,55 @@ namespace faif {
         /** incremental learn - add training example  */
         template<typename Val>
         void NaiveBayesian<Val>::trainIncremental(const ExampleTrain& example) {
+            if( frozen_ )
+                throw ModelFrozenException();
             impl_->addTraining(example);
         }
 
+        /** learn from counters, the same as trainIncremental of the counted examples */
+        template<typename Val>
+        void NaiveBayesian<Val>::addCounters(AttrIdd cat_val, int cat_count, const ValueCounters& value_counters) {
+            if( frozen_ )
+                throw ModelFrozenException();
+            impl_->addCounters(cat_val, cat_count, value_counters);
+        }
+
+        /** switch to classify state (calculate probabilities) and forbid the further changes */
+        template<typename Val>
+        void NaiveBayesian<Val>::freeze() {
+            impl_->loadSaveState(); //no-op if already in classify state
+            frozen_ = true;
+        }
+
+        /** switch to classify state (calculate probabilities), the training stays allowed */
+        template<typename Val>
+        void NaiveBayesian<Val>::switchClassify() {
+            if( frozen_ )
+                throw ModelFrozenException();
+            impl_->loadSaveState(); //no-op if already in classify state
+        }
+
+        /** the log-probability of given category, only in classify state */
+        template<typename Val>
+        Probability NaiveBayesian<Val>::getCategoryLogProbability(AttrIdd cat_val) const {
+            return classifyState().getCategoryCounterLog(cat_val);
+        }
+
+        /** the log-probability of given attribute value in given category, only in classify state */
+        template<typename Val>
+        Probability NaiveBayesian<Val>::getValueLogProbability(AttrIdd cat_val, AttrIdd value) const {
+            return classifyState().getCategoryValCounterLog(cat_val, value);
+        }
+
+        /** the classify state, probabilities are stored only in NaiveBayesianClasify */
+        template<typename Val>
+        const typename NaiveBayesian<Val>::NaiveBayesianClasify& NaiveBayesian<Val>::classifyState() const {
+            const NaiveBayesianClasify* classify = dynamic_cast<const NaiveBayesianClasify*>(impl_.get());
+            if( classify == 0L )
+                throw ModelNotFrozenException();
+            return *classify;
+        }
+
         /** ostraem method */
         template<typename Val>
         void NaiveBayesian<Val>::write(std::ostream& os) const {
@@ -378,6 +557,7 @@ namespace faif {
             trainIncremental(example); //re-call the method
         }
 
+
         /** change the internal obj to classify and return the internal state */
         template<typename Val>
         void NaiveBayesian<Val>::switchLoadSaveState() {
@@ -399,6 +579,8 @@ namespace faif {
         template<typename Val>
         template<class Archive>
         void NaiveBayesian<Val>::load(Archive & ar, const unsigned int /* file_version */) {
+            if( frozen_ )
+                throw ModelFrozenException();
             ar.template register_type<NaiveBayesianClasify>();
             ar >> boost::serialization::make_nvp("NBCBase", boost::serialization::base_object<Classifier<Val> >(*this) );
             NaiveBayesianTraining* t;
@@ -494,6 +676,23 @@ namespace faif {
             }
         }
 
+        /** adds the counters of many training examples of given category */
+        template<typename Val>
+        void NaiveBayesian<Val>::NaiveBayesianTraining::addCounters(AttrIdd cat_val, int cat_count, const ValueCounters& value_counters) {
+            if( cat_count <= 0 )
+                return;
+            typename CategoryCounters::iterator ii = counters_.find(cat_val);
+            if( ii != counters_.end() )
+                (*ii).second.data_ += cat_count;
+            else
+                ii = counters_.insert( typename CategoryCounters::value_type(cat_val,cat_count) ).first;
+            SimpleCounters& count = (*ii).second.attrData_;
+            for(typename ValueCounters::const_iterator i = value_counters.begin(); i != value_counters.end(); ++i ) {
+                if( i->second > 0 )
+                    count[i->first] += i->second;
+            }
+        }
+
         /** ostream method */
         template<typename Val>
         void NaiveBayesian<Val>::NaiveBayesianTraining::write(std::ostream& os) const {
@@ -553,21 +752,26 @@ namespace faif {
             return cat_val_max;
         }
 
-        /** classifies the given example. Using Naive Bayesian approach, return the AttrIdd and belief pairs */
+        /** classifies the given example. Using Naive Bayesian approach, return the AttrIdd and belief pairs.
+            Each category is scored once, the log-probabilities are normalized by the stable log-sum-exp */
         template<typename Val>
         typename NaiveBayesian<Val>::Beliefs
         NaiveBayesian<Val>::NaiveBayesianClasify::getCategories(const ExampleTest& example) {
-            Probability sum = 0.0;
+            std::vector<AttrIdd> categories;
+            std::vector<Probability> probs; //contiguous buffer of log-probabilities
+            categories.reserve(probabl_.size());
+            probs.reserve(probabl_.size());
             for(typename InternalProbabilities::const_iterator ii = probabl_.begin(); ii != probabl_.end(); ++ii ) {
-                sum += std::exp( calcProbabilityForExample(example, (*ii).first ) );
+                categories.push_back( (*ii).first );
+                probs.push_back( calcProbabilityForExample(example, (*ii).first ) );
             }
+            if( !probs.empty() )
+                normalizeLogProbabilities(&probs[0], probs.size());
 
             Beliefs toRet;
-            for(typename InternalProbabilities::const_iterator ii = probabl_.begin(); ii != probabl_.end(); ++ii ) {
-                AttrIdd cat_val = (*ii).first;
-                Probability prob = exp( calcProbabilityForExample(example, cat_val) ) / sum;
-                toRet.push_back(typename Beliefs::value_type(cat_val, prob));
-            }
+            toRet.reserve(probs.size());
+            for(std::size_t i = 0; i < probs.size(); ++i)
+                toRet.push_back(typename Beliefs::value_type(categories[i], probs[i]));
             std::sort( toRet.begin(), toRet.end() );
             return toRet;
         }
@@ -591,7 +795,7 @@ namespace faif {
         Probability NaiveBayesian<Val>::NaiveBayesianClasify::getCategoryCounterLog(AttrIdd cat_val) const {
             typename InternalProbabilities::const_iterator ii = probabl_.find(cat_val);
             if( ii != probabl_.end() )
-                return (*ii).second.data_;
+                return (*ii).second.data_ - categoryDenominator_;
             else
                 return 0.0;
         }
@@ -613,59 +817,118 @@ namespace faif {
             //przeszukuje dana kategorie;
             typename Counters::const_iterator jj = counters.find(value);
             if( jj != counters.end() )
-                return (*jj).second;
+                return (*jj).second - denominators_.find(cat_val)->second[ value->getDomain()->getSize() ];
             else
                 return 0.0;
         }
 
-        namespace {
-            /** helping - calculates the probability of given value, laplace smoothing (m-szacowanie) and log */
-            Probability calcProbability( int val_count, int count_all, int val_size) {
-                return std::log((val_count + 1)/ (Probability)(count_all + val_size ));
-            }
-
-        } //namespace
-
-
         /** calculate the probabilities */
         template<typename Val>
         void NaiveBayesian<Val>::NaiveBayesianClasify::calculate(const NaiveBayesianTraining& nb_train) {
+            if( &nb_train != this )
+                this->counters_ = nb_train.counters_; //keep the counters for online learning
 
             //calculates the sum of category counters
-            int sumTraining = 0;
+            sumTraining_ = 0;
             const AttrDomain& category = this->parent_->getCategoryDomain();
             for(typename AttrDomain::const_iterator ii = category.begin(); ii != category.end(); ++ii ) {
                 AttrIdd catVal = AttrDomain::getValueId(ii);
-                sumTraining += nb_train.getCategoryCounter(catVal);
+                sumTraining_ += NaiveBayesianTraining::getCategoryCounter(catVal);
             }
+            categoryDenominator_ = std::log( (Probability)(category.getSize() + sumTraining_) );
+
+            const Domains& attribs = this->parent_->getAttrDomains();
+            maxValSize_ = 0;
+            for(typename Domains::const_iterator jj = attribs.begin(); jj != attribs.end(); ++jj)
+                maxValSize_ = std::max(maxValSize_, jj->getSize());
 
-            //calculate probability fo each attribute value
-            int catSize = category.getSize();
+            //calculate numerators fo each attribute value, laplace smoothing (m-szacowanie) and log
+            probabl_.clear();
+            denominators_.clear();
             for(typename AttrDomain::const_iterator ii = category.begin(); ii != category.end(); ++ii ) {
                 AttrIdd catVal = AttrDomain::getValueId(ii);
-                int catCounter = nb_train.getCategoryCounter(catVal);
-                Probability catProb = calcProbability( catCounter, catSize, sumTraining );
+                Probability catProb = std::log( (Probability)(NaiveBayesianTraining::getCategoryCounter(catVal) + 1) );
                 Counters counters; //empty counters
-                const Domains& attribs = this->parent_->getAttrDomains();
                 for(typename Domains::const_iterator jj = attribs.begin(); jj != attribs.end(); ++jj) {
                     const AttrDomain& attr = *jj;
-                    int valSize = attr.getSize(); //number values for given attribute (for Laplace' smoothing)
                     for(typename AttrDomain::const_iterator kk = attr.begin(); kk != attr.end(); ++kk) {
                         AttrIdd val = AttrDomain::getValueId(kk);
-                        Probability valProb = calcProbability( nb_train.getCategoryValCounter(catVal, val), valSize, catCounter );
+                        Probability valProb = std::log( (Probability)(NaiveBayesianTraining::getCategoryValCounter(catVal, val) + 1) );
                         counters.insert( typename Counters::value_type(val, valProb) );
                     }
                 }
                 probabl_.insert( typename InternalProbabilities::value_type(catVal, CategoryData<Probability>(catProb, counters) ) );
+                calcDenominators(catVal);
             }
         }
 
+        /** calculate the denominators for given category, for each attribute domain size */
+        template<typename Val>
+        void NaiveBayesian<Val>::NaiveBayesianClasify::calcDenominators(AttrIdd cat_val) {
+            int catCounter = NaiveBayesianTraining::getCategoryCounter(cat_val);
+            std::vector<Probability>& denominators = denominators_[cat_val];
+            denominators.resize(maxValSize_ + 1);
+            for(int valSize = 0; valSize <= maxValSize_; ++valSize)
+                denominators[valSize] = std::log( (Probability)(valSize + catCounter) );
+        }
+
+        /** update the numerators of the category and given values, and the denominators, after the counters changed */
+        template<typename Val>
+        template<typename It>
+        void NaiveBayesian<Val>::NaiveBayesianClasify::update(AttrIdd cat_val, int added, It values_begin, It values_end) {
+            typename InternalProbabilities::iterator ii = probabl_.find(cat_val);
+            if( ii == probabl_.end() )
+                return; //not a category of the domain, only counted
+            sumTraining_ += added;
+            categoryDenominator_ = std::log( (Probability)(this->parent_->getCategoryDomain().getSize() + sumTraining_) );
+            (*ii).second.data_ = std::log( (Probability)(NaiveBayesianTraining::getCategoryCounter(cat_val) + 1) );
+            Counters& counters = (*ii).second.attrData_;
+            for(It it = values_begin; it != values_end; ++it) {
+                typename Counters::iterator jj = counters.find(*it);
+                if( jj != counters.end() )
+                    (*jj).second = std::log( (Probability)(NaiveBayesianTraining::getCategoryValCounter(cat_val, *it) + 1) );
+            }
+            calcDenominators(cat_val);
+        }
+
+        /** adds the training example, updates the probabilities of its category */
+        template<typename Val>
+        void NaiveBayesian<Val>::NaiveBayesianClasify::addTraining(const ExampleTrain& example) {
+            if( !hasCounters_ )
+                throw ModelWithoutCountersException();
+            NaiveBayesianTraining::addTraining(example);
+            update(example.getFeature(), 1, example.begin(), example.end());
+        }
+
+        /** adds the counters, updates the probabilities of the category */
+        template<typename Val>
+        void NaiveBayesian<Val>::NaiveBayesianClasify::addCounters(AttrIdd cat_val, int cat_count, const ValueCounters& value_counters) {
+            if( cat_count <= 0 )
+                return;
+            if( !hasCounters_ )
+                throw ModelWithoutCountersException();
+            NaiveBayesianTraining::addCounters(cat_val, cat_count, value_counters);
+            std::vector<AttrIdd> values;
+            values.reserve(value_counters.size());
+            for(typename ValueCounters::const_iterator i = value_counters.begin(); i != value_counters.end(); ++i )
+                values.push_back(i->first);
+            update(cat_val, cat_count, values.begin(), values.end());
+        }
+
         /** calculate log-probability for given example and category */
         template<typename Val>
         Probability NaiveBayesian<Val>::NaiveBayesianClasify::calcProbabilityForExample(const ExampleTest& example, AttrIdd cat_val) const {
-            Probability prob = getCategoryCounterLog(cat_val);
-            for(typename ExampleTest::const_iterator ii = example.begin(); ii !=  example.end(); ++ii )
-                prob += getCategoryValCounterLog(cat_val, *ii );
+            typename InternalProbabilities::const_iterator ii = probabl_.find(cat_val);
+            if( ii == probabl_.end() )
+                return 0.0;
+            const Counters& counters = (*ii).second.attrData_;
+            const std::vector<Probability>& denominators = denominators_.find(cat_val)->second;
+            Probability prob = (*ii).second.data_ - categoryDenominator_;
+            for(typename ExampleTest::const_iterator jj = example.begin(); jj !=  example.end(); ++jj ) {
+                typename Counters::const_iterator kk = counters.find(*jj);
+                if( kk != counters.end() )
+                    prob += (*kk).second - denominators[ (*jj)->getDomain()->getSize() ];
+            }
             return prob;
         }
 
@@ -674,22 +937,257 @@ namespace faif {
         template<class Archive>
         void NaiveBayesian<Val>::NaiveBayesianClasify::save(Archive & ar, const unsigned int /* file_version */) const {
             ar << boost::serialization::make_nvp("Base", boost::serialization::base_object<NaiveBayesianTraining>(*this));
-            ar << boost::serialization::make_nvp("InternalProb",probabl_);
+            ar << boost::serialization::make_nvp("Counters",this->counters_);
         }
 
         /** \brief serialization using boost::serialization */
         template<typename Val>
         template<class Archive>
-        void NaiveBayesian<Val>::NaiveBayesianClasify::load(Archive & ar, const unsigned int /* file_version */) {
+        void NaiveBayesian<Val>::NaiveBayesianClasify::load(Archive & ar, const unsigned int file_version) {
             ar >> boost::serialization::make_nvp("Base", boost::serialization::base_object<NaiveBayesianTraining>(*this));
+            if( file_version == 0 ) {
+                loadProbabilities(ar);
+                return;
+            }
+            typedef std::map<AttrIddSerialize, CategoryData<int> > Map;
+            Map m;
+            ar >> boost::serialization::make_nvp("Counters",m);
+            this->counters_.clear();
+            for(typename Map::const_iterator ii = m.begin(); ii != m.end(); ++ii) {
+                this->counters_.insert( typename NaiveBayesianTraining::CategoryCounters::value_type(ii->first, ii->second) );
+            }
+            hasCounters_ = true;
+            calculate(*this); //the probabilities are not stored
+        }
+
+        /** \brief serialization version 0: the whole log-probabilities, the numerators with zero denominators */
+        template<typename Val>
+        template<class Archive>
+        void NaiveBayesian<Val>::NaiveBayesianClasify::loadProbabilities(Archive & ar) {
             typedef std::map<AttrIddSerialize, CategoryData<Probability> > Map;
             Map m;
             ar >> boost::serialization::make_nvp("InternalProb",m);
+            const Domains& attribs = this->parent_->getAttrDomains();
+            maxValSize_ = 0;
+            for(typename Domains::const_iterator jj = attribs.begin(); jj != attribs.end(); ++jj)
+                maxValSize_ = std::max(maxValSize_, jj->getSize());
+            this->counters_.clear();
             probabl_.clear();
+            denominators_.clear();
             for(typename Map::const_iterator ii = m.begin(); ii != m.end(); ++ii) {
                 probabl_.insert( typename InternalProbabilities::value_type(ii->first, ii->second) );
-		    }
-	    }
+                denominators_[ii->first].assign(maxValSize_ + 1, 0.0);
+            }
+            sumTraining_ = 0;
+            categoryDenominator_ = 0.0;
+            hasCounters_ = false;
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////
+        // class NaiveBayesianCompiled
+        //////////////////////////////////////////////////////////////////////////////////////////////////
+
+        /** \brief Compiled (dense) form of the trained Naive Bayesian Classifier.
+
+            The categories and the attribute values are numbered by dense integer ids (values of each attribute
+            have consecutive ids, starting from getAttrOffset), the log-probabilities are stored in one contiguous
+            table, row for each category. Scoring the example is the gather and sum over one row.
+            For the most probable categories (getTopCategories) the categories are visited by decreasing
+            log-probability, and a category is left when its partial score plus the maximum log-probabilities
+            (over all categories) of the remaining values cannot enter the top.
+            The object is read-only after construction. NaiveBayesian remains the reference implementation.
+            The compiled classifier has to be in classify state (NaiveBayesian::freeze or switchClassify) first,
+            otherwise the constructor throws ModelNotFrozenException.
+        */
+        template<typename Val>
+        class NaiveBayesianCompiled {
+        public:
+            typedef typename Classifier<Val>::AttrDomain AttrDomain;
+            typedef typename Classifier<Val>::AttrIdd AttrIdd;
+            typedef typename Classifier<Val>::Domains Domains;
+            typedef typename Classifier<Val>::ExampleTest ExampleTest;
+
+            /** \brief the example as dense value ids, one id for each attribute */
+            typedef std::vector<int> DenseExample;
+
+            /** \brief compile the trained classifier */
+            explicit NaiveBayesianCompiled(const NaiveBayesian<Val>& nb);
+
+            /** \brief accessor */
+            int getCategoriesCount() const { return static_cast<int>(categories_.size()); }
+            /** \brief accessor */
+            int getAttributesCount() const { return static_cast<int>(offsets_.size()); }
+            /** \brief accessor - number of attribute values (all attributes) */
+            int getValuesCount() const { return rowSize_ - 1; }
+            /** \brief the dense id of the first value of given attribute */
+            int getAttrOffset(int attr) const { return offsets_[attr]; }
+            /** \brief the dense id used for unknown value, its log-probability is 0 */
+            int getUnknownValueId() const { return rowSize_ - 1; }
+
+            /** \brief the dense id for given attribute value, getUnknownValueId() if not found */
+            int getValueId(AttrIdd value) const;
+            /** \brief the category for given dense category id */
+            AttrIdd getCategoryIdd(int cat) const { return categories_[cat]; }
+
+            /** \brief transform the test example to dense value ids */
+            DenseExample toDense(const ExampleTest& example) const;
+
+            /** \brief the log-probability of given category (category log-probability and example values log-probabilities) */
+            Probability score(const DenseExample& example, int cat) const;
+
+            /** \brief classify, return the dense id of the most probable category (-1 if no categories) */
+            int getCategoryId(const DenseExample& example) const;
+
+            /** \brief the k most probable categories (dense category id, log-probability), the most probable first */
+            void getTopCategories(const DenseExample& example, int k, std::vector<std::pair<int, Probability> >& best) const;
+
+            /** \brief the probability of each category [dense category id], getCategoriesCount() values */
+            void getBeliefs(const DenseExample& example, Probability* beliefs) const;
+
+            /** \brief classify (the same result as NaiveBayesian::getCategory) */
+            AttrIdd getCategory(const ExampleTest& example) const;
+
+            /** \brief the category log-probabilities table [category] */
+            const Probability* getCategoryLogProbabilities() const { return &catProb_[0]; }
+            /** \brief the value log-probabilities table [category][value] */
+            const Probability* getValueLogProbabilities() const { return &valueProb_[0]; }
+            /** \brief the size of one category row in value log-probabilities table (the values and unknown value) */
+            int getRowSize() const { return rowSize_; }
+        private:
+            /** \brief orders the categories by decreasing log-probability */
+            struct CategoryOrder {
+                explicit CategoryOrder(const std::vector<Probability>& prob) : prob_(prob) {}
+                bool operator()(int a, int b) const { return prob_[a] > prob_[b]; }
+                const std::vector<Probability>& prob_;
+            };
+            /** \brief the log-probabilities of the example in the category, for topCategories */
+            struct ExampleScore {
+                ExampleScore(const NaiveBayesianCompiled& nb, const DenseExample& example) : nb_(nb), example_(example) {}
+                Probability operator()(int cat) const { return nb_.catProb_[cat]; }
+                Probability operator()(int cat, std::size_t i) const { return nb_.valueProb_[cat * nb_.rowSize_ + example_[i]]; }
+                const NaiveBayesianCompiled& nb_;
+                const DenseExample& example_;
+            };
+
+            std::vector<AttrIdd> categories_;
+            std::vector<int> offsets_;
+            boost::unordered_map<AttrIdd, int> valueIds_;
+            int rowSize_;
+            std::vector<Probability> catProb_;
+            std::vector<Probability> valueProb_;
+            std::vector<Probability> maxValueProb_; //[value], maximum over categories
+            std::vector<int> catOrder_; //categories by decreasing log-probability
+        };
+
+        /** compile the trained classifier: number the values and copy the log-probabilities */
+        template<typename Val>
+        NaiveBayesianCompiled<Val>::NaiveBayesianCompiled(const NaiveBayesian<Val>& nb) : rowSize_(1) {
+            const Domains& attribs = nb.getAttrDomains();
+            for(typename Domains::const_iterator jj = attribs.begin(); jj != attribs.end(); ++jj) {
+                offsets_.push_back(rowSize_ - 1);
+                for(typename AttrDomain::const_iterator kk = jj->begin(); kk != jj->end(); ++kk) {
+                    valueIds_.insert( std::make_pair(AttrDomain::getValueId(kk), rowSize_ - 1) );
+                    ++rowSize_;
+                }
+            }
+
+            const AttrDomain& category = nb.getCategoryDomain();
+            for(typename AttrDomain::const_iterator ii = category.begin(); ii != category.end(); ++ii ) {
+                AttrIdd catVal = AttrDomain::getValueId(ii);
+                categories_.push_back(catVal);
+                catProb_.push_back( nb.getCategoryLogProbability(catVal) );
+                for(typename Domains::const_iterator jj = attribs.begin(); jj != attribs.end(); ++jj) {
+                    for(typename AttrDomain::const_iterator kk = jj->begin(); kk != jj->end(); ++kk) {
+                        valueProb_.push_back( nb.getValueLogProbability(catVal, AttrDomain::getValueId(kk)) );
+                    }
+                }
+                valueProb_.push_back(0.0); //unknown value
+            }
+            maxValueProb_.assign(rowSize_, -std::numeric_limits<Probability>::max());
+            for(int cat = 0; cat < getCategoriesCount(); ++cat) {
+                catOrder_.push_back(cat);
+                for(int v = 0; v < rowSize_; ++v)
+                    maxValueProb_[v] = std::max(maxValueProb_[v], valueProb_[cat * rowSize_ + v]);
+            }
+            std::stable_sort(catOrder_.begin(), catOrder_.end(), CategoryOrder(catProb_));
+            if( categories_.empty() ) { //keep the tables accessible
+                catProb_.push_back(0.0);
+                valueProb_.push_back(0.0);
+                maxValueProb_.assign(1, 0.0);
+            }
+        }
+
+        /** the dense id for given attribute value */
+        template<typename Val>
+        int NaiveBayesianCompiled<Val>::getValueId(AttrIdd value) const {
+            typename boost::unordered_map<AttrIdd, int>::const_iterator ii = valueIds_.find(value);
+            if( ii != valueIds_.end() )
+                return ii->second;
+            else
+                return getUnknownValueId();
+        }
+
+        /** transform the test example to dense value ids */
+        template<typename Val>
+        typename NaiveBayesianCompiled<Val>::DenseExample
+        NaiveBayesianCompiled<Val>::toDense(const ExampleTest& example) const {
+            DenseExample dense;
+            dense.reserve(example.size());
+            for(typename ExampleTest::const_iterator ii = example.begin(); ii != example.end(); ++ii )
+                dense.push_back( getValueId(*ii) );
+            return dense;
+        }
+
+        /** the log-probability of given category for the example */
+        template<typename Val>
+        Probability NaiveBayesianCompiled<Val>::score(const DenseExample& example, int cat) const {
+            const Probability* row = &valueProb_[cat * rowSize_];
+            Probability prob = catProb_[cat];
+            for(DenseExample::const_iterator ii = example.begin(); ii != example.end(); ++ii )
+                prob += row[*ii];
+            return prob;
+        }
+
+        /** classify, return the dense id of the most probable category (the lowest id for equal probabilities) */
+        template<typename Val>
+        int NaiveBayesianCompiled<Val>::getCategoryId(const DenseExample& example) const {
+            std::vector<std::pair<int, Probability> > best;
+            getTopCategories(example, 1, best);
+            return best.empty() ? -1 : best.front().first;
+        }
+
+        /** the k most probable categories, the categories which can not enter the top are not scored to the end */
+        template<typename Val>
+        void NaiveBayesianCompiled<Val>::getTopCategories(const DenseExample& example, int k,
+                                                          std::vector<std::pair<int, Probability> >& best) const {
+            std::vector<Probability> rest(example.size() + 1, 0.0); //maximum of the values example[i..]
+            for(std::size_t i = example.size(); i-- > 0; )
+                rest[i] = rest[i + 1] + maxValueProb_[example[i]];
+            topCategories(catOrder_, rest, ExampleScore(*this, example), static_cast<std::size_t>(std::max(k, 0)), best);
+        }
+
+        /** the probability of each category, scored once into the table and normalized by the stable log-sum-exp */
+        template<typename Val>
+        void NaiveBayesianCompiled<Val>::getBeliefs(const DenseExample& example, Probability* beliefs) const {
+            const int categories = getCategoriesCount();
+            std::copy(catProb_.begin(), catProb_.begin() + categories, beliefs);
+            for(DenseExample::const_iterator ii = example.begin(); ii != example.end(); ++ii ) {
+                const Probability* column = &valueProb_[*ii];
+                for(int cat = 0; cat < categories; ++cat) //stride rowSize_, no dependencies between categories
+                    beliefs[cat] += column[cat * rowSize_];
+            }
+            normalizeLogProbabilities(beliefs, categories);
+        }
+
+        /** classify (the same result as NaiveBayesian::getCategory) */
+        template<typename Val>
+        typename NaiveBayesianCompiled<Val>::AttrIdd
+        NaiveBayesianCompiled<Val>::getCategory(const ExampleTest& example) const {
+            int cat = getCategoryId( toDense(example) );
+            if( cat < 0 )
+                return AttrDomain::getUnknownId();
+            return categories_[cat];
+        }
 
     } //namespace ml
 } //namespace faif
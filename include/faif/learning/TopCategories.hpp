@@ -0,0 +1,81 @@
+#ifndef FAIF_TOP_CATEGORIES_HPP_
+#define FAIF_TOP_CATEGORIES_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace faif {
+
+    namespace ml {
+
+        /** \brief relative margin of the bounds in topCategories
+
+            The bound of a category and its score are sums of the same log-probabilities in a different order,
+            so they differ by the rounding. A category is left only when its bound is below the k-th score
+            by more than 1e-9 of the magnitude, then the search gives the same top as scoring every category.
+        */
+        const double TOP_BOUND_MARGIN = 1e-9;
+
+        /** \brief the higher log-probability first, the lower category id for equal */
+        struct TopCategoryOrder {
+            bool operator()(const std::pair<int, double>& a, const std::pair<int, double>& b) const {
+                return a.second > b.second || (a.second == b.second && a.first < b.first);
+            }
+        };
+
+        /** \brief the k most probable categories (category id, log-probability as faif::Probability), the most probable first
+
+            The log-probability of a category is score(cat) plus score(cat, i) for the terms i = 0..n-1, where
+            n = bound.size() - 1 and bound[i] is not lower than the sum of the terms i.. of any category
+            (bound[n] == 0). The categories are visited in the given order, by decreasing score(cat).
+            A category is left as soon as its partial log-probability plus the bound of the remaining terms
+            can not enter the top, and the search stops at the first category whose score(cat) plus bound[0]
+            can not. Gives the same categories as sorting all of them, equal log-probabilities by category id.
+        */
+        template<typename Score>
+        void topCategories(const std::vector<int>& order, const std::vector<double>& bound, const Score& score,
+                           std::size_t k, std::vector<std::pair<int, double> >& best) {
+            typedef std::pair<int, double> CategoryProb;
+            best.clear();
+            k = std::min(k, order.size());
+            if( k == 0 )
+                return;
+            const std::size_t n = bound.size() - 1;
+            best.reserve(k);
+            TopCategoryOrder better; //the heap of the best categories, the worst on the front
+            for(std::vector<int>::const_iterator cc = order.begin(); cc != order.end(); ++cc) {
+                const int cat = *cc;
+                double prob = score(cat);
+                if( best.size() < k ) {
+                    for(std::size_t i = 0; i < n; ++i)
+                        prob += score(cat, i);
+                }
+                else {
+                    const double kth = best.front().second;
+                    const double threshold = kth - TOP_BOUND_MARGIN * (1.0 + std::fabs(kth));
+                    if( prob + bound[0] < threshold )
+                        break; //the next categories have lower scores
+                    std::size_t i = 0;
+                    for(; i < n; ++i) {
+                        prob += score(cat, i);
+                        if( prob + bound[i + 1] < threshold )
+                            break;
+                    }
+                    if( i < n || !better(CategoryProb(cat, prob), best.front()) )
+                        continue;
+                    std::pop_heap(best.begin(), best.end(), better);
+                    best.pop_back();
+                }
+                best.push_back(CategoryProb(cat, prob));
+                std::push_heap(best.begin(), best.end(), better);
+            }
+            std::sort_heap(best.begin(), best.end(), better);
+        }
+
+    } //namespace ml
+} //namespace faif
+
+#endif //FAIF_TOP_CATEGORIES_HPP_
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include "bayesian_webclass/async_downloader.h"
+#include "curl/curl.h"
+
+
+/** Request sent by the transfer
+ */
+enum Method {
+    GET,
+    HEAD,
+    FIRST_BYTE      //GET of the first byte, for servers not answering HEAD
+};
+
+/** One queued or running download
+ */
+struct AsyncDownloader::Transfer {
+    std::string url;
+    std::string host;
+    std::string body;
+    Callback callback;
+    Method method;
+    CheckCallback check;            //set for liveness checks
+    double seconds;                 //time of the finished requests of the check
+    bool cached;                    //entry holds the cached page
+    PageCache::Entry entry;
+    struct curl_slist *headers;     //conditional request headers
+    PageCache::ResponseHeaders response;    //cache headers of the response
+};
+
+/**Append the received chunk to the body of the transfer
+ */
+static std::size_t appendBody(void *ptr, std::size_t size, std::size_t nmemb, void *transfer) {
+    std::string *body = static_cast<std::string *>(transfer);
+    body->append(static_cast<const char *>(ptr), size * nmemb);
+    return size * nmemb;
+}
+
+/**Stop the transfer on the first received chunk, only the status is needed
+ */
+static std::size_t dropBody(void *, std::size_t, std::size_t, void *) {
+    return 0;
+}
+
+/**Constructor
+ * @param max_in_flight maximum number of transfers running at once
+ * @param max_per_host maximum number of transfers to the same host running at once
+ * @param timeout maximum time of one transfer in seconds
+ * @param session connection state shared with other downloaders, a new one if empty
+ */
+AsyncDownloader::AsyncDownloader(int max_in_flight, int max_per_host, long timeout,
+                                 std::shared_ptr<DownloadSession> session)
+        : _session(session ? session : std::make_shared<DownloadSession>()), _multi(curl_multi_init()),
+          _max_in_flight(std::max(1, max_in_flight)), _max_per_host(std::max(1, max_per_host)),
+          _timeout(timeout), _in_flight(0), _cache(nullptr) {
+    _session->configureMulti(_multi);
+}
+
+/**Destructor
+ * Transfers which were not run are dropped without calling their callbacks.
+ */
+AsyncDownloader::~AsyncDownloader() {
+    for (Transfer *t : _queue) {
+        delete t;
+    }
+    for (Transfer *t : _cached) {
+        delete t;
+    }
+    curl_multi_cleanup(_multi);
+}
+
+/**Queue the url to download
+ * @param url url address to download
+ * @param callback called by run when the download is finished
+ */
+void AsyncDownloader::add(const std::string &url, const Callback &callback) {
+    Transfer *t = new Transfer();
+    t->url = url;
+    t->host = getHost(url);
+    t->callback = callback;
+    t->method = GET;
+    t->seconds = 0;
+    t->headers = nullptr;
+    t->cached = _cache && _cache->lookup(url, t->entry);
+    if (t->cached && _cache->isFresh(t->entry)) {
+        t->body.swap(t->entry.body);
+        _cached.push_back(t);
+        return;
+    }
+    _queue.push_back(t);
+}
+
+/**Queue the liveness check of the url
+ * HEAD is sent first; if the server answers it with an error or closes
+ * the connection, the first byte of the page is requested instead.
+ * The page cache is not used.
+ * @param url url address to check
+ * @param callback called by run when the check is finished
+ */
+void AsyncDownloader::check(const std::string &url, const CheckCallback &callback) {
+    Transfer *t = new Transfer();
+    t->url = url;
+    t->host = getHost(url);
+    t->method = HEAD;
+    t->check = callback;
+    t->seconds = 0;
+    t->cached = false;
+    t->headers = nullptr;
+    _queue.push_back(t);
+}
+
+/**Set the page cache
+ * @param cache cache used for the urls added later, must outlive the downloader; nullptr - no cache
+ */
+void AsyncDownloader::setCache(const PageCache *cache) {
+    _cache = cache;
+}
+
+/**Number of queued transfers which were not started yet
+ */
+std::size_t AsyncDownloader::pending() const {
+    return _queue.size() + _cached.size();
+}
+
+/**Download all queued urls
+ * Returns when every transfer is finished and its callback called.
+ * Callbacks may add new urls, they are downloaded in the same run.
+ * Fresh cached pages are delivered while the downloads are running.
+ * @param source called in every iteration to add urls, run also waits
+ *        for it (woken up by wakeup) until it returns false; empty - none
+ */
+void AsyncDownloader::run(const Source &source) {
+    bool more = static_cast<bool>(source);
+    if (more) {
+        more = source();
+    }
+    startTransfers();
+    while (_in_flight > 0 || !_cached.empty() || more) {
+        while (!_cached.empty()) {
+            Transfer *t = _cached.front();
+            _cached.pop_front();
+            deliver(t, true);
+        }
+        int running = 0;
+        curl_multi_perform(_multi, &running);
+
+        CURLMsg *msg;
+        int left = 0;
+        while ((msg = curl_multi_info_read(_multi, &left))) {
+            if (msg->msg == CURLMSG_DONE) {
+                finishTransfer(msg->easy_handle, msg->data.result);
+            }
+        }
+        if (more) {
+            more = source();
+        }
+        startTransfers();
+        if (_cached.empty() && (_in_flight > 0 || more)) {
+            curl_multi_poll(_multi, nullptr, 0, 100, nullptr);
+        }
+    }
+}
+
+/**Wake up run waiting for the transfers
+ * May be called from any thread, e.g. by the producer of the Source.
+ */
+void AsyncDownloader::wakeup() {
+    curl_multi_wakeup(_multi);
+}
+
+/**Start queued transfers while the limits allow it
+ * The first queued transfer whose host is below max_per_host is started,
+ * transfers to busy hosts stay in the queue in their order.
+ */
+void AsyncDownloader::startTransfers() {
+    for (std::deque<Transfer *>::iterator it = _queue.begin();
+         it != _queue.end() && _in_flight < _max_in_flight;) {
+        Transfer *t = *it;
+        int &host_in_flight = _host_in_flight[t->host];
+        if (host_in_flight >= _max_per_host) {
+            ++it;
+            continue;
+        }
+        CURL *easy = curl_easy_init();
+        curl_easy_setopt(easy, CURLOPT_URL, t->url.c_str());
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT, _timeout);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        _session->configure(easy, t->url);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &t->body);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, appendBody);
+        if (t->method == HEAD) {
+            curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+        } else if (t->method == FIRST_BYTE) {
+            curl_easy_setopt(easy, CURLOPT_RANGE, "0-0");
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, dropBody); //also when the range is ignored
+        } else if (_cache) {
+            if (t->cached) {
+                for (const std::string &header : PageCache::conditionalHeaders(t->entry)) {
+                    t->headers = curl_slist_append(t->headers, header.c_str());
+                }
+                curl_easy_setopt(easy, CURLOPT_HTTPHEADER, t->headers);
+            }
+            curl_easy_setopt(easy, CURLOPT_HEADERDATA, &t->response);
+            curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, PageCache::headerCallback);
+        }
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, t);
+        curl_multi_add_handle(_multi, easy);
+
+        ++host_in_flight;
+        ++_in_flight;
+        it = _queue.erase(it);
+    }
+}
+
+/**Remove the finished transfer and deliver its body to the callback
+ * @param easy curl easy handle of the transfer
+ * @param result CURLcode of the transfer
+ */
+void AsyncDownloader::finishTransfer(void *easy, int result) {
+    Transfer *t = nullptr;
+    long status = 0;
+    double seconds = 0;
+    curl_easy_getinfo(easy, CURLINFO_PRIVATE, &t);
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME, &seconds);
+    curl_multi_remove_handle(_multi, easy);
+    curl_easy_cleanup(easy);
+    curl_slist_free_all(t->headers);
+    t->headers = nullptr;
+
+    std::map<std::string, int>::iterator host = _host_in_flight.find(t->host);
+    if (--host->second == 0) {
+        _host_in_flight.erase(host); //only hosts with running transfers are kept
+    }
+    --_in_flight;
+    if (t->check) {
+        if (finishCheck(t, result, status, seconds)) {
+            delete t;
+        }
+        return;
+    }
+    bool success = result == CURLE_OK;
+    if (_cache) {
+        success = _cache->finishResponse(t->url, t->cached ? &t->entry : nullptr, success, status, t->body,
+                                         t->response.etag, t->response.last_modified);
+    }
+    deliver(t, success);
+}
+
+/**Call the callback of the transfer and delete it
+ * @param t finished transfer
+ * @param success true if the body holds the page
+ */
+void AsyncDownloader::deliver(Transfer *t, bool success) {
+    if (t->callback) {
+        t->callback(t->url, success, t->body);
+    }
+    delete t;
+}
+
+/**Report the result of the liveness check or retry it with a GET
+ * @param t finished check
+ * @param result CURLcode of the request
+ * @param status HTTP status of the response
+ * @param seconds time of the request
+ * @return false if the check was queued again with the GET of the first byte
+ */
+bool AsyncDownloader::finishCheck(Transfer *t, int result, long status, double seconds) {
+    t->seconds += seconds;
+    if (t->method == HEAD && (status >= 400 || result == CURLE_GOT_NOTHING)) {
+        t->method = FIRST_BYTE;
+        _queue.push_front(t);
+        return false;
+    }
+    bool answered = result == CURLE_OK || (t->method == FIRST_BYTE && result == CURLE_WRITE_ERROR);
+    t->check(t->url, answered ? status : 0, t->seconds);
+    return true;
+}
+
+/**Get the host part of the url
+ * Per-host limits are counted on it, so "scheme://host:port" is returned.
+ * @param url url address
+ * @return scheme and host of the url
+ */
+std::string AsyncDownloader::getHost(const std::string &url) {
+    std::string::size_type begin = url.find("://");
+    begin = (begin == std::string::npos) ? 0 : begin + 3;
+    return url.substr(0, url.find_first_of("/?#", begin));
+}
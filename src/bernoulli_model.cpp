@@ -0,0 +1,182 @@
+#include "bayesian_webclass/bernoulli_model.h"
+#include "faif/learning/TopCategories.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+/** \brief Constructor.
+ * Creates an empty model, use build or attach to set the tables.
+ */
+
+BernoulliModel::BernoulliModel() : _attributes(0), _categories(0),
+                                   _baseline(nullptr), _delta(nullptr) {}
+
+/** \brief Build the model from Naive Bayesian log-probability tables.
+ * The value of attribute a in category c is at
+ * value_log_prob[c * row_size + 2 * a + v], where v is 0 (absent)
+ * or 1 (present), as in the NaiveBayesianCompiled tables of binary
+ * attributes.
+ * @param attributes number of attributes
+ * @param categories number of categories
+ * @param category_log_prob log-probability of each category
+ * @param value_log_prob log-probabilities of attribute values
+ * @param row_size size of the table row of one category
+ */
+
+void BernoulliModel::build(std::size_t attributes, std::size_t categories,
+                           const double* category_log_prob,
+                           const double* value_log_prob,
+                           std::size_t row_size) {
+    _storage.assign(categories + attributes * categories, 0.0);
+    double* baseline = &_storage[0];
+    double* delta = baseline + categories;
+
+    for(std::size_t c = 0; c < categories; ++c) {
+        const double* row = value_log_prob + c * row_size;
+        double absent = category_log_prob[c];
+        for(std::size_t a = 0; a < attributes; ++a) {
+            absent += row[2 * a];
+            delta[a * categories + c] = row[2 * a + 1] - row[2 * a];
+        }
+        baseline[c] = absent;
+    }
+    _attributes = attributes;
+    _categories = categories;
+    _baseline = baseline;
+    _delta = delta;
+    sortCategories();
+}
+
+/** \brief Use external tables.
+ * The tables are not copied and have to outlive the model.
+ * @param attributes number of attributes
+ * @param categories number of categories
+ * @param baseline log-probability of each category with all attributes absent
+ * @param delta change of log-probability when an attribute is present,
+ *        [attribute][category]
+ */
+
+void BernoulliModel::attach(std::size_t attributes, std::size_t categories,
+                            const double* baseline, const double* delta) {
+    _storage.clear();
+    _attributes = attributes;
+    _categories = categories;
+    _baseline = baseline;
+    _delta = delta;
+    sortCategories();
+}
+
+/** \brief Change the baselines of all categories.
+ * All at once, as the categories are sorted by the baseline again.
+ * @param baseline getCategoryCount() log-probabilities of the
+ *        categories with all attributes absent
+ * @return false if the tables are external
+ */
+
+bool BernoulliModel::setBaselines(const double* baseline) {
+    if(_storage.empty())
+        return false;
+    std::copy(baseline, baseline + _categories, _storage.begin());
+    std::stable_sort(_order.begin(), _order.end(), [this](int a, int b) {
+        return _baseline[a] > _baseline[b];
+    });
+    return true;
+}
+
+/** \brief Change the deltas of all attributes of a category.
+ * @param category id of the category
+ * @param delta getAttributeCount() changes of log-probability when
+ *        an attribute is present
+ * @return false if the tables are external
+ */
+
+bool BernoulliModel::setDelta(std::size_t category, const double* delta) {
+    if(_storage.empty() || category >= _categories)
+        return false;
+    double* column = &_storage[_categories + category];
+    for(std::size_t a = 0; a < _attributes; ++a) {
+        column[a * _categories] = delta[a];
+        _max_delta[a] = std::max(_max_delta[a], delta[a]);   // still a bound if lowered
+    }
+    return true;
+}
+
+/** \brief Log-probability of every category for the example.
+ * @param[in] example sparse example, ids lower than getAttributeCount()
+ * @param[out] scores getCategoryCount() log-probabilities
+ */
+
+void BernoulliModel::score(const SparseExample& example, double* scores) const {
+    std::copy(_baseline, _baseline + _categories, scores);
+    for(int a : example) {
+        const double* row = _delta + a * _categories;
+        for(std::size_t c = 0; c < _categories; ++c)
+            scores[c] += row[c];
+    }
+}
+
+/** \brief Classify the example.
+ * The first of top, ties go to the lowest category id.
+ * @param example sparse example
+ * @return id of the most probable category, -1 if there are no categories
+ */
+
+int BernoulliModel::classify(const SparseExample& example) const {
+    std::vector<CategoryScore> best;
+    top(example, 1, best);
+    return best.empty() ? -1 : best.front().first;
+}
+
+/** \struct BernoulliModel::ExampleScore
+ *  \brief Baseline and deltas of the example in a category, for faif::ml::topCategories.
+ */
+
+struct BernoulliModel::ExampleScore {
+    ExampleScore(const BernoulliModel& model, const SparseExample& example)
+        : model(model), example(example) {}
+    double operator()(int c) const { return model._baseline[c]; }
+    double operator()(int c, std::size_t i) const {
+        return model._delta[example[i] * model._categories + c];
+    }
+    const BernoulliModel& model;
+    const SparseExample& example;
+};
+
+/** \brief The most probable categories of the example.
+ * Gives the same categories and scores as sorting score, ties in
+ * the order of category ids, but the categories which cannot enter
+ * the top are not scored to the end (see the class description).
+ * @param[in] example sparse example
+ * @param[in] k number of categories
+ * @param[out] best min(k, getCategoryCount()) categories with their
+ *             log-probabilities, the most probable first
+ */
+
+void BernoulliModel::top(const SparseExample& example, std::size_t k,
+                         std::vector<CategoryScore>& best) const {
+    // rest[i]: bound of the deltas of attributes i.. of the example
+    std::vector<double> rest(example.size() + 1, 0.0);
+    for(std::size_t i = example.size(); i-- > 0; )
+        rest[i] = rest[i + 1] + _max_delta[example[i]];
+    faif::ml::topCategories(_order, rest, ExampleScore(*this, example), k, best);
+}
+
+/** \brief Compute the bounds of the deltas and the order of the
+ * categories, after the tables were set.
+ */
+
+void BernoulliModel::sortCategories() {
+    _max_delta.assign(_attributes, -std::numeric_limits<double>::infinity());
+    for(std::size_t a = 0; a < _attributes; ++a) {
+        const double* row = _delta + a * _categories;
+        for(std::size_t c = 0; c < _categories; ++c)
+            _max_delta[a] = std::max(_max_delta[a], row[c]);
+    }
+    _order.resize(_categories);
+    for(std::size_t c = 0; c < _categories; ++c)
+        _order[c] = static_cast<int>(c);
+    std::stable_sort(_order.begin(), _order.end(), [this](int a, int b) {
+        return _baseline[a] > _baseline[b];
+    });
+}
@@ -1,59 +1,66 @@
 #include "bayesian_webclass/classifier.h"
+#include "bayesian_webclass/model_snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <thread>
+#include <boost/filesystem/operations.hpp>
 
 
+/** bytes of the per-thread count tables of countExamples */
+static const std::size_t COUNT_TABLES_MEMORY = static_cast<std::size_t>(256) << 20;
+
 /** \brief Method for classifier initialization.
  * Initializes the classifier with given attribute list,
  * categories and trains the classifier on a number of examples
- * in the given directory.
+ * in the given directory. The examples are read and counted
+ * by many threads, see countExamples.
  * @param attributes name of the file listing all attributes
  * @param categories name of the file listing all categories
  * @param examples_dir directory containing examples
  * @param examples_num number of examples to be used (and available
  *        in the examples_dir)
+ * @param threads number of threads reading the examples, 0 for the
+ *        number of hardware threads
+ * @return false if an example cannot be read or has an unknown
+ *         category; the classifier is not trained then
  */
 
-void Classifier::init(std::string attributes,
+bool Classifier::init(std::string attributes,
                       std::string categories,
                       std::string examples_dir,
-                      int examples_num) {
+                      int examples_num,
+                      unsigned threads) {
     loadAttributes(attributes);
     loadCategories(categories);
 
-    _nb = new NBint(_attribs, _cat);
-
-    std::string example;
-    for(int i = 0; i <= examples_num; ++i) {
-        example = examples_dir + std::to_string(i) + ".txt";
-        loadExample(example);
+    CountTable counts;
+    if(!countExamples(examples_dir, 0, examples_num, counts, threads)) {
+        std::cerr << "Not all examples could be read, the classifier is not trained" << std::endl;
+        return false;
     }
-
-    _nb->train(_ex);
+    return trainFromCounts(counts);
 }
 
 /** \brief Method loading attributes from a given file.
  * Loads attributes from the given file into the internal
  * faif::ml::NaiveBayesian<faif::ValueNominal<int>>::Domains
- * object.
+ * object. The attribute of a word is found through the interned
+ * Vocabulary, with one hash probe per token.
  * @param attributes name of the file listing all attributes
  */
 
 void Classifier::loadAttributes(std::string attributes) {
-    std::vector<std::string> word_list;
-    std::ifstream input;
-    input.open(attributes);
-    std::string word;
-
-    while(input >> word) {
-        word_list.push_back(word);
-    }
+    _vocabulary = std::make_shared<Vocabulary>();
+    _vocabulary->load(attributes);
 
     int A[] = {0, 1};   // A generic binary attribute,
                         // using int to allow int category
 
-    int index = 0;
-    for(std::string w : word_list) {
-        _attribs.push_back(faif::createDomain(w, A, A+2));
-        _attrib_index[w] = index++;
+    for(std::size_t i = 0; i < _vocabulary->size(); ++i) {
+        _attribs.push_back(faif::createDomain(_vocabulary->getWord(i).to_string(), A, A+2));
     }
 }
 
@@ -87,30 +94,288 @@ void Classifier::loadCategories(std::string categories) {
     _cat = faif::createDomain("", C, C+_cat_list.size());
 }
 
-/** \brief Method loading an example from a given file.
- * Loads an example from the given file into the internal
- * faif::ml::NaiveBayesian<faif::ValueNominal<int>>::ExamplesTrain
- * object.
- * @param example name of the file with the example
+/** \brief Method counting the examples in parallel.
+ * Every thread reads and tokenises the example files it takes into
+ * its own CountTable, the tables are merged at the end, so the
+ * threads do not share anything but the index of the next file.
+ * The tables are dense (categories x attributes), so the number of
+ * threads is limited to keep all of them within COUNT_TABLES_MEMORY.
+ * Examples which cannot be read or have an unknown category are
+ * skipped. The attributes and categories have to be loaded first.
+ * A range of examples can be counted on every machine, the saved
+ * tables merged and trained once, see trainFromCounts.
+ * @param[in] examples_dir directory containing examples first.txt ... last.txt
+ * @param[in] first number of the first example
+ * @param[in] last number of the last example
+ * @param[out] counts counters of the examples, for the loaded attributes
+ *             and categories
+ * @param[in] threads number of threads, 0 for the number of hardware threads
+ * @return false if some examples were skipped
  */
 
-void Classifier::loadExample(std::string example) {
-    std::ifstream input;
-    input.open(example);
-    std::string word;
-    int cat;
-    if(!(input >> word)) {
-        throw;
+bool Classifier::countExamples(const std::string& examples_dir, int first, int last,
+                               CountTable& counts, unsigned threads) const {
+    counts = CountTable(_cat_list.size(), _vocabulary->size(), CountTable::makeKey(*_vocabulary, _cat_list));
+    const int examples = std::max(0, last - first + 1);
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, examples));
+    const std::size_t table_size = std::max<std::size_t>(1, _cat_list.size() * _vocabulary->size() * sizeof(int));
+    threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, COUNT_TABLES_MEMORY / table_size));
+
+    std::vector<CountTable> tables(threads, counts);
+    std::atomic<int> next(0);
+    std::atomic<bool> ok(true);
+    auto worker = [&](unsigned t) {
+        std::string buffer;
+        SparseExample ex;
+        int cat;
+        for(int i = next++; i < examples; i = next++) {
+            if(!readExample(examples_dir + std::to_string(first + i) + ".txt", buffer, cat, ex)) {
+                ok = false;
+                continue;
+            }
+            std::sort(ex.begin(), ex.end());
+            ex.erase(std::unique(ex.begin(), ex.end()), ex.end());
+            tables[t].add(cat, ex);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
     }
-    cat = _cat_index.at(word);
+    worker(0);
+    for(std::thread& t : pool) {
+        t.join();
+    }
+    for(const CountTable& table : tables) {
+        counts.merge(table);
+    }
+    return ok;
+}
 
-    int E[_attrib_index.size()]{};
-    while(input >> word) {
-        if(_attrib_index.find(word) != _attrib_index.end()) {
-            E[_attrib_index.at(word)] = 1;
+/** \brief Method reading one example file.
+ * The first word of the file is the category, the other words
+ * which are attributes are given by their ids.
+ * @param[in] example name of the file with the example
+ * @param buffer contents of the file, reused between calls
+ * @param[out] cat category of the example, index in the categories file
+ * @param[out] ex ids of the attributes in the order of the file, with
+ *             repetitions
+ * @return false if the file cannot be read or its category is unknown
+ */
+
+bool Classifier::readExample(const std::string& example, std::string& buffer,
+                             int& cat, SparseExample& ex) const {
+    std::ifstream input(example, std::ios::binary);
+    if(!input.is_open()) {
+        std::cerr << "Cannot read example: " << example << std::endl;
+        return false;
+    }
+    input.seekg(0, std::ios::end);
+    buffer.resize(std::max<std::streamoff>(0, input.tellg()));
+    input.seekg(0, std::ios::beg);
+    input.read(&buffer[0], buffer.size());
+    buffer.resize(input.gcount());
+
+    cat = -1;
+    ex.clear();
+    const char* p = buffer.data();
+    const char* end = p + buffer.size();
+    while(p != end) {
+        while(p != end && std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        const char* word = p;
+        while(p != end && !std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        if(word == p)
+            break;
+        if(cat < 0) {
+            std::map<std::string, int>::const_iterator it = _cat_index.find(std::string(word, p));
+            if(it == _cat_index.end()) {
+                std::cerr << "Unknown category of example: " << example << std::endl;
+                return false;
+            }
+            cat = it->second;
+        }
+        else {
+            int id = _vocabulary->find(Vocabulary::view(word, p - word));
+            if(id >= 0)
+                ex.push_back(id);
+        }
+    }
+    if(cat < 0) {
+        std::cerr << "Empty example: " << example << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** \brief Method training the classifier on counted examples.
+ * The counters are added to faif::ml::NaiveBayesian for every
+ * category at once: value 1 of an attribute with its count, value 0
+ * with the rest of the category examples. The probabilities are the
+ * same as after training on the examples one by one. The classifier
+ * is then switched to the classify state and compiled, ready to
+ * classify and to learn online (see learn).
+ * @param counts counters of the training examples, e.g. merged from
+ *        the tables saved by many workers
+ * @return false if the table does not match the loaded attributes
+ *         and categories
+ */
+
+bool Classifier::trainFromCounts(const CountTable& counts) {
+    if(!_vocabulary || counts.getCategoryCount() != _cat_list.size()
+       || counts.getAttributeCount() != _vocabulary->size()
+       || counts.getKey() != CountTable::makeKey(*_vocabulary, _cat_list)) {
+        std::cerr << "Counts do not match attributes and categories" << std::endl;
+        return false;
+    }
+    _nb.reset(new NBint(_attribs, _cat));     // a new model, also when trained again
+
+    std::vector<std::pair<NBint::AttrIdd, NBint::AttrIdd>> values;   // ids of values 0 and 1
+    for(const AttrDomain& attr : _nb->getAttrDomains()) {
+        values.push_back(std::make_pair(attr.find(0), attr.find(1)));
+    }
+
+    NBint::ValueCounters counters;
+    for(std::size_t c = 0; c < counts.getCategoryCount(); ++c) {
+        const int examples = counts.getExamples(c);
+        const int* present = counts.getCounts(c);
+        counters.clear();
+        for(std::size_t a = 0; a < values.size(); ++a) {
+            counters.push_back(std::make_pair(values[a].second, present[a]));
+            counters.push_back(std::make_pair(values[a].first, examples - present[a]));
         }
+        _nb->addCounters(_nb->getCategoryDomain().find(static_cast<int>(c)), examples, counters);
     }
-    _ex.push_back(faif::ml::createExample(E, E+_attrib_index.size(), cat, *_nb));
+
+    _nb->switchClassify();  // changed from now on only by learn, under _model_mutex
+    _compiled.reset(new NBcompiled(*_nb));
+    _model.build(_vocabulary->size(), _compiled->getCategoriesCount(),   // binary attributes,
+                 _compiled->getCategoryLogProbabilities(),              // values 0 and 1
+                 _compiled->getValueLogProbabilities(),                 // at offsets 2a, 2a + 1
+                 _compiled->getRowSize());
+    _absent_log_prob.clear();
+    return true;
+}
+
+/** \brief Method training the multinomial (or complement) classifier.
+ * The example files are read as link-count vectors, optionally
+ * weighted by TF-IDF, and a MultinomialModel is trained on them.
+ * From then on the classify methods use it instead of the binary
+ * (Bernoulli) model; classifyReference, learn and saveSnapshot still
+ * use the binary model. The attributes and categories have to be
+ * loaded first, e.g. by init.
+ * @param examples_dir directory containing examples first.txt ... last.txt
+ * @param first number of the first example
+ * @param last number of the last example
+ * @param variant multinomial or complement Naive Bayesian weights
+ * @param tfidf true to weight the links by TF-IDF, in training and
+ *        in classification
+ * @return false if some examples were skipped
+ */
+
+bool Classifier::trainMultinomial(const std::string& examples_dir, int first, int last,
+                                  MultinomialModel::Variant variant, bool tfidf) {
+    std::vector<TermVector> documents;
+    std::vector<int> labels;
+    std::string buffer;
+    SparseExample ex;
+    bool ok = true;
+    for(int i = first; i <= last; ++i) {
+        int cat;
+        if(!readExample(examples_dir + std::to_string(i) + ".txt", buffer, cat, ex)) {
+            ok = false;
+            continue;
+        }
+        documents.push_back(TfIdf::toTerms(ex));
+        labels.push_back(cat);
+    }
+
+    _tfidf = TfIdf();
+    if(tfidf) {
+        _tfidf.fit(documents, _vocabulary->size());
+        for(TermVector& doc : documents) {
+            _tfidf.apply(doc);
+        }
+    }
+    _multinomial.reset(new MultinomialModel());
+    _multinomial->train(_vocabulary->size(), _cat_list.size(), documents, labels, variant);
+    return ok;
+}
+
+/** \brief Method adding a labelled example to the trained classifier.
+ * Online learning: the example is added to the counters of the
+ * faif::ml::NaiveBayesian in classify state (see
+ * NaiveBayesian::switchClassify and trainIncremental),
+ * then only the model column of its category and the category
+ * baselines are read back, in O(attributes + categories), no
+ * retraining is done. The classify methods and classifyReference
+ * use the updated model; they may run concurrently and wait for
+ * the update.
+ * @param attribs set of attributes (links) found in the example
+ * @param category name of the category of the example
+ * @return false if the classifier is not trained or the category
+ *         is unknown
+ */
+
+bool Classifier::learn(const std::set<std::string>& attribs, const std::string& category) {
+    std::map<std::string, int>::const_iterator it = _cat_index.find(category);
+    if(!_compiled || it == _cat_index.end()) {
+        std::cerr << "Cannot learn example of category: " << category << std::endl;
+        return false;
+    }
+    std::vector<int> E(_vocabulary->size(), 0);
+    for(const std::string& word : attribs) {
+        int id = _vocabulary->find(word);
+        if(id >= 0)
+            E[id] = 1;
+    }
+
+    boost::unique_lock<boost::shared_mutex> lock(_model_mutex);
+    const std::size_t C = _model.getCategoryCount();
+    if(_absent_log_prob.empty()) {  // first update, sums of the trained model
+        for(std::size_t m = 0; m < C; ++m) {
+            _absent_log_prob.push_back(absentLogProbability(_compiled->getCategoryIdd(m)->get()));
+        }
+    }
+    _nb->trainIncremental(createExample(E.begin(), E.end(), it->second, *_nb));
+
+    std::vector<double> baseline(C);
+    for(std::size_t m = 0; m < C; ++m) {
+        NBint::AttrIdd cat = _compiled->getCategoryIdd(m);
+        if(cat->get() == it->second) {
+            std::vector<double> delta;
+            delta.reserve(E.size());
+            for(const AttrDomain& attr : _nb->getAttrDomains()) {
+                delta.push_back(_nb->getValueLogProbability(cat, attr.find(1))
+                                - _nb->getValueLogProbability(cat, attr.find(0)));
+            }
+            _model.setDelta(m, delta.data());
+            _absent_log_prob[m] = absentLogProbability(it->second);
+        }
+        baseline[m] = _nb->getCategoryLogProbability(cat) + _absent_log_prob[m];
+    }
+    if(C > 0)
+        _model.setBaselines(baseline.data());
+    return true;
+}
+
+/** \brief Method giving the log-probability of an example of the
+ * category without any attributes, as in faif::ml::NaiveBayesian,
+ * without the category probability.
+ * @param cat category, index in the categories file
+ */
+
+double Classifier::absentLogProbability(int cat) const {
+    NBint::AttrIdd cat_val = _nb->getCategoryDomain().find(cat);
+    double sum = 0.0;
+    for(const AttrDomain& attr : _nb->getAttrDomains()) {
+        sum += _nb->getValueLogProbability(cat_val, attr.find(0));
+    }
+    return sum;
 }
 
 /** \brief Method classifying a given test example.
@@ -120,21 +385,278 @@ void Classifier::loadExample(std::string example) {
  * @param example name of the file with the test example
  */
 
-std::string Classifier::classify(std::string example) {
+std::string Classifier::classify(std::string example) const {
     std::ifstream input;
     input.open(example);
     std::string word;
 
-    int E[_attrib_index.size()]{};
+    SparseExample ex;
     while(input >> word) {
-        if(_attrib_index.find(word) != _attrib_index.end())
-            E[_attrib_index.at(word)] = 1;
+        addAttribute(word, ex);
     }
-    ExampleTest et = createExample(E, E+_attrib_index.size(), *_nb);
+    return classifyExample(ex);
+}
+
+/** \brief Method classifying a test example given in memory.
+ * Same as classify(std::string) but takes the attributes directly,
+ * e.g. as returned by DataPreprocessor::get_attribs_from_link,
+ * so no example file has to be written and read back.
+ * @param attribs set of attributes (links) found in the example
+ */
+
+std::string Classifier::classify(const std::set<std::string>& attribs) const {
+    SparseExample ex;
+    for(const std::string& word : attribs) {
+        addAttribute(word, ex);
+    }
+    return classifyExample(ex);
+}
+
+/** \brief Method giving the most probable categories of a test example.
+ * Returns the category ids and log-probabilities directly, without
+ * the names; the Bernoulli model skips the categories which cannot
+ * enter the top (see BernoulliModel::top), the multinomial model
+ * scores all categories.
+ * @param attribs set of attributes (links) found in the example
+ * @param k number of categories
+ * @return min(k, categories) pairs (category, log-probability or
+ *         score), the most probable first; the category is the index
+ *         in the categories file, see getCategoryName
+ */
+
+std::vector<CategoryScore> Classifier::classifyTop(const std::set<std::string>& attribs,
+                                                   std::size_t k) const {
+    SparseExample ex;
+    for(const std::string& word : attribs) {
+        addAttribute(word, ex);
+    }
+    std::vector<CategoryScore> best;
+    if(_multinomial) {
+        TermVector terms = TfIdf::toTerms(ex);
+        _tfidf.apply(terms);
+        std::vector<double> scores(_multinomial->getCategoryCount());
+        if(!scores.empty())
+            _multinomial->score(terms, &scores[0]);
+        for(std::size_t c = 0; c < scores.size(); ++c) {
+            best.push_back(CategoryScore(static_cast<int>(c), scores[c]));
+        }
+        k = std::min(k, best.size());
+        std::partial_sort(best.begin(), best.begin() + k, best.end(),
+                          [](const CategoryScore& a, const CategoryScore& b) {
+            return a.second > b.second || (a.second == b.second && a.first < b.first);
+        });
+        best.resize(k);
+        return best;
+    }
+    boost::shared_lock<boost::shared_mutex> lock(_model_mutex);
+    _model.top(ex, k, best);
+    for(CategoryScore& c : best) {
+        c.first = _compiled->getCategoryIdd(c.first)->get();
+    }
+    return best;
+}
+
+/** \brief Method giving the name of a category.
+ * @param id index of the category in the categories file
+ * @return name of the category
+ */
+
+const std::string& Classifier::getCategoryName(int id) const {
+    return _cat_list.at(id);
+}
+
+/** \brief Method classifying many documents in parallel.
+ * Every document is scored against the same trained model, which is
+ * only read, so the documents are split between the threads without
+ * locking. Must not be called concurrently with init.
+ * @param documents documents given in memory, whitespace separated
+ *        words (links) as in the example files, without the category
+ * @param threads number of threads, 0 for the number of hardware threads
+ * @return results in the order of the documents
+ */
+
+std::vector<BatchResult> Classifier::classifyBatch(const std::vector<std::string>& documents,
+                                                   unsigned threads) const {
+    std::vector<BatchResult> results(documents.size());
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<std::size_t>(threads, documents.size());
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        for(std::size_t i = next++; i < documents.size(); i = next++) {
+            classifyDocument(documents[i], results[i]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& t : pool) {
+        t.join();
+    }
+    return results;
+}
+
+/** \brief Method classifying all documents in a directory.
+ * Reads every regular file of the directory and classifies the
+ * files with classifyBatch.
+ * @param[in] directory directory with the documents
+ * @param[out] files names of the classified files, sorted, in the
+ *             order of the results
+ * @param[in] threads number of threads, 0 for the number of hardware threads
+ * @return results in the order of files, empty if the directory
+ *         cannot be read
+ */
+
+std::vector<BatchResult> Classifier::classifyDirectory(const std::string& directory,
+                                                       std::vector<std::string>& files,
+                                                       unsigned threads) const {
+    files.clear();
+    boost::system::error_code ec;
+    for(boost::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if(boost::filesystem::is_regular_file(it->status()))
+            files.push_back(it->path().string());
+    }
+    if(ec) {
+        std::cerr << "Cannot read directory: " << directory << std::endl;
+        files.clear();
+        return std::vector<BatchResult>();
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::string> documents;
+    documents.reserve(files.size());
+    for(const std::string& f : files) {
+        std::ifstream input(f);
+        std::stringstream buffer;
+        buffer << input.rdbuf();
+        documents.push_back(buffer.str());
+    }
+    return classifyBatch(documents, threads);
+}
+
+/** \brief Method classifying a test example with the map-based classifier.
+ * Reference implementation for classify(const std::set<std::string>&),
+ * uses faif::ml::NaiveBayesian directly instead of the compiled tables.
+ * @param attribs set of attributes (links) found in the example
+ */
+
+std::string Classifier::classifyReference(const std::set<std::string>& attribs) const {
+    std::vector<int> E(_vocabulary->size(), 0);
+    for(const std::string& word : attribs) {
+        int id = _vocabulary->find(word);
+        if(id >= 0)
+            E[id] = 1;
+    }
+    ExampleTest et = createExample(E.begin(), E.end(), *_nb);
+    boost::shared_lock<boost::shared_mutex> lock(_model_mutex);
+    return _cat_list.at(_nb->getCategory(et)->get());
+}
+
+/** \brief Method adding the attribute id of a word to a sparse example.
+ * Words which are not attributes are skipped.
+ * @param word word (link) found in the example
+ * @param ex sparse example
+ */
+
+void Classifier::addAttribute(const std::string& word, SparseExample& ex) const {
+    int id = _vocabulary->find(word);
+    if(id >= 0)
+        ex.push_back(id);
+}
+
+/** \brief Method classifying a sparse example.
+ * Only the present attributes are scored, see BernoulliModel, or
+ * MultinomialModel if it was trained.
+ * @param ex ids of attributes present in the example, sorted and
+ *        made unique (or counted) here
+ * @return name of the most probable category
+ */
+
+std::string Classifier::classifyExample(SparseExample& ex) const {
+    if(_multinomial) {
+        TermVector terms = TfIdf::toTerms(ex);
+        _tfidf.apply(terms);
+        return _cat_list.at(_multinomial->classify(terms));
+    }
+    std::sort(ex.begin(), ex.end());
+    ex.erase(std::unique(ex.begin(), ex.end()), ex.end());
+    boost::shared_lock<boost::shared_mutex> lock(_model_mutex);
+    int cat = _model.classify(ex);
+    return _cat_list.at(_compiled->getCategoryIdd(cat)->get());
+}
+
+/** \brief Method classifying one document of a batch.
+ * Beliefs are the softmax of the category log-probabilities (or
+ * scores of the multinomial model), by the stable log-sum-exp of
+ * faif::ml::normalizeLogProbabilities.
+ * @param[in] document whitespace separated words (links)
+ * @param[out] result category and beliefs of the document
+ */
+
+void Classifier::classifyDocument(const std::string& document, BatchResult& result) const {
+    std::istringstream input(document);
+    std::string word;
+    SparseExample ex;
+    while(input >> word) {
+        addAttribute(word, ex);
+    }
+    std::vector<double> scores;
+    if(_multinomial) {
+        TermVector terms = TfIdf::toTerms(ex);
+        _tfidf.apply(terms);
+        scores.resize(_multinomial->getCategoryCount());
+        if(!scores.empty())
+            _multinomial->score(terms, &scores[0]);
+    }
+    else {
+        std::sort(ex.begin(), ex.end());
+        ex.erase(std::unique(ex.begin(), ex.end()), ex.end());
+        scores.resize(_model.getCategoryCount());
+        boost::shared_lock<boost::shared_mutex> lock(_model_mutex);
+        if(!scores.empty())
+            _model.score(ex, &scores[0]);
+    }
+    result.beliefs.assign(_cat_list.size(), 0.0);
+    if(scores.empty())
+        return;
+
+    auto category = [this](std::size_t c) {    // index in the categories file
+        return _multinomial ? static_cast<int>(c) : _compiled->getCategoryIdd(c)->get();
+    };
+    std::size_t best = std::max_element(scores.begin(), scores.end()) - scores.begin();
+    faif::ml::normalizeLogProbabilities(&scores[0], scores.size());
+    for(std::size_t c = 0; c < scores.size(); ++c) {
+        result.beliefs[category(c)] = scores[c];
+    }
+    result.category = _cat_list.at(category(best));
+}
+
+/** \brief Method saving the trained classifier to a snapshot file.
+ * Writes the attributes, categories and log-probabilities of the
+ * trained classifier in the ModelSnapshot binary format, so another
+ * process can classify without loading and training on examples.
+ * @param filename name of the snapshot file
+ * @return true if the file was written
+ */
+
+bool Classifier::saveSnapshot(const std::string& filename) const {
+    std::vector<std::string> categories;    // in the order of model categories
+    for(int c = 0; c < _compiled->getCategoriesCount(); ++c) {
+        categories.push_back(_cat_list.at(_compiled->getCategoryIdd(c)->get()));
+    }
+    boost::shared_lock<boost::shared_mutex> lock(_model_mutex);
+    return ModelSnapshot::write(filename, _vocabulary->getWords(), categories, _model);
+}
+
+/** \brief Method giving the attribute vocabulary.
+ * The vocabulary can be shared, e.g. by a Dictionary, without copying.
+ * @return vocabulary of the attributes, ids are attribute indices
+ */
 
-    std::stringstream ss;
-    ss << _nb->getCategory(et);
-    word = ss.str();
-    word.erase(0, 1);
-    return _cat_list.at(std::stoi(word));
+std::shared_ptr<const Vocabulary> Classifier::getVocabulary() const {
+    return _vocabulary;
 }
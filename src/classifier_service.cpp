@@ -0,0 +1,162 @@
+#include "bayesian_webclass/classifier_service.h"
+
+
+/** \brief Constructor.
+ * The service is not ready until init is called.
+ */
+
+ClassifierService::ClassifierService() : _session(std::make_shared<DownloadSession>()) {}
+
+/** \brief Method for service initialization.
+ * Loads attributes, categories and examples and trains the
+ * classifier. Done once, the trained classifier is kept in memory
+ * and used by all following classify calls.
+ * @param attributes name of the file listing all attributes
+ * @param categories name of the file listing all categories
+ * @param examples_dir directory containing examples
+ * @param examples_num number of examples to be used
+ * @return false if the classifier cannot be trained, the service
+ *         keeps the previous classifier then
+ */
+
+bool ClassifierService::init(const std::string& attributes,
+                             const std::string& categories,
+                             const std::string& examples_dir,
+                             int examples_num) {
+    std::shared_ptr<Classifier> classifier(new Classifier());
+    if(!classifier->init(attributes, categories, examples_dir, examples_num))
+        return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _classifier = std::move(classifier);
+    _snapshot.reset();
+    return true;
+}
+
+/** \brief Method for service initialization from a snapshot.
+ * Maps the snapshot file written by Classifier::saveSnapshot,
+ * no examples are read and no training is done.
+ * @param snapshot name of the snapshot file
+ * @return false if the snapshot cannot be loaded
+ */
+
+bool ClassifierService::load(const std::string& snapshot) {
+    std::shared_ptr<ModelSnapshot> model(new ModelSnapshot());
+    if(!model->open(snapshot))
+        return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _snapshot = std::move(model);
+    _classifier.reset();
+    return true;
+}
+
+/** \brief Method initializing the service on first use.
+ * The ready check and the initialization are done under one lock,
+ * so concurrent first requests load or train the classifier once;
+ * the others wait for it. Classification by the ready service is
+ * not blocked by the lock.
+ * @param snapshot name of the snapshot file, loaded if it exists
+ * @param attributes name of the file listing all attributes
+ * @param categories name of the file listing all categories
+ * @param examples_dir directory containing examples
+ * @param examples_num number of examples to be used
+ * @return true if the service is ready
+ */
+
+bool ClassifierService::initOnce(const std::string& snapshot,
+                                 const std::string& attributes,
+                                 const std::string& categories,
+                                 const std::string& examples_dir,
+                                 int examples_num) {
+    std::lock_guard<std::mutex> lock(_init_mutex);
+    return isReady() || load(snapshot) || init(attributes, categories, examples_dir, examples_num);
+}
+
+/** \brief Check if the service was initialized.
+ * @return true if the classifier is trained or loaded from a snapshot
+ */
+
+bool ClassifierService::isReady() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _classifier != nullptr || _snapshot != nullptr;
+}
+
+/** \brief Method classifying an article given by url.
+ * Downloads the article, extracts its attributes in memory and
+ * classifies them with the already trained classifier. The lock is
+ * held only to take the current model; the download (see getAttribs)
+ * and classification run without it, on the model which was current
+ * when the call started, waiting only for a running learn update.
+ * @param[in] url url address of en.wikipedia.org article
+ * @param[out] category name of the most probable category
+ * @return false if the service is not initialized or the article
+ *         cannot be downloaded
+ */
+
+bool ClassifierService::classify(const std::string& url, std::string& category) {
+    std::shared_ptr<Classifier> classifier;
+    std::shared_ptr<const ModelSnapshot> snapshot;
+    std::set<std::string> attribs;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        classifier = _classifier;
+        snapshot = _snapshot;
+    }
+    if((!classifier && !snapshot) || !getAttribs(url, attribs))
+        return false;
+
+    category = snapshot ? snapshot->classify(attribs) : classifier->classify(attribs);
+    return true;
+}
+
+/** \brief Method adding a labelled article to the trained classifier.
+ * Downloads the article as classify does and adds it to the model,
+ * see Classifier::learn; the following classify calls use the
+ * updated model. The snapshot model is read-only.
+ * @param url url address of en.wikipedia.org article
+ * @param category name of the category of the article
+ * @return false if the service is not trained, the article cannot
+ *         be downloaded or the category is unknown
+ */
+
+bool ClassifierService::learn(const std::string& url, const std::string& category) {
+    std::shared_ptr<Classifier> classifier;
+    std::set<std::string> attribs;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        classifier = _classifier;
+    }
+    if(!classifier || !getAttribs(url, attribs))
+        return false;
+
+    return classifier->learn(attribs, category);
+}
+
+/** \brief Method downloading the attributes of an article.
+ * Takes an idle downloader from the pool, or creates one when all
+ * are used by other calls, and returns it after the download, so
+ * its connection is reused by the next call.
+ * @param[in] url url address of en.wikipedia.org article
+ * @param[out] attribs attributes (links) found in the article
+ * @return false if the article cannot be downloaded
+ */
+
+bool ClassifierService::getAttribs(const std::string& url, std::set<std::string>& attribs) {
+    std::unique_ptr<HTTPDownloader> http;
+    {
+        std::lock_guard<std::mutex> lock(_downloaders_mutex);
+        if(!_downloaders.empty()) {
+            http = std::move(_downloaders.back());
+            _downloaders.pop_back();
+        }
+    }
+    if(!http)
+        http.reset(new HTTPDownloader(_session));
+
+    bool success = DataPreprocessor::get_attribs_from_link(*http, url, attribs);
+
+    std::lock_guard<std::mutex> lock(_downloaders_mutex);
+    _downloaders.push_back(std::move(http));
+    return success;
+}
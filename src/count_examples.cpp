@@ -0,0 +1,21 @@
+#include <bayesian_webclass/classifier.h>
+#include <iostream>
+#include <string>
+int main(int argc, char* argv[]) {  //counts a range of examples and saves the counters, see merge_counts
+
+    if (argc < 7) {
+        std::cerr << "Usage: " << argv[0] << " attributes categories examples_dir first last counts [threads]" << std::endl;
+        return 1;
+    }
+
+    Classifier c;
+    c.loadAttributes(argv[1]);
+    c.loadCategories(argv[2]);
+    CountTable counts;
+    bool ok = c.countExamples(argv[3], std::stoi(argv[4]), std::stoi(argv[5]), counts,
+                              argc > 7 ? std::stoul(argv[7]) : 0);
+    if (!counts.save(argv[6])) {
+        return 1;
+    }
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,195 @@
+#include "bayesian_webclass/count_table.h"
+#include "bayesian_webclass/fnv_hash.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+
+/** \struct CountTable::Header
+ *  \brief Fixed size header at the beginning of the counts file.
+ */
+
+struct CountTable::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t category_count;
+    std::uint32_t attribute_count;
+    std::uint32_t reserved;
+    std::uint64_t key;              // hash of attribute and category names
+};
+
+static const char MAGIC[8] = {'B', 'W', 'C', 'C', 'O', 'U', 'N', 'T'};
+
+
+/** \brief Constructor, an empty table without categories.
+ */
+
+CountTable::CountTable() : _categories(0), _attributes(0), _key(0) {}
+
+/** \brief Constructor, a table with all counters zero.
+ * @param categories number of categories
+ * @param attributes number of binary attributes
+ * @param key hash of the attribute and category names, see makeKey
+ */
+
+CountTable::CountTable(std::size_t categories, std::size_t attributes, std::uint64_t key)
+    : _categories(categories), _attributes(attributes), _key(key),
+      _examples(categories, 0), _counts(categories * attributes, 0) {}
+
+/** \brief Key of the tables counted against the given names.
+ * FNV-1a of the attribute names and then the category names, in
+ * the order of their ids, every name followed by a zero byte.
+ * @param attributes attribute names, ids are attribute indices
+ * @param categories category names, in the order of category ids
+ * @return the key, never 0
+ */
+
+std::uint64_t CountTable::makeKey(const Vocabulary& attributes,
+                                  const std::vector<std::string>& categories) {
+    std::uint64_t hash = FNV1A_BASIS;
+    for(std::size_t a = 0; a < attributes.size(); ++a) {
+        Vocabulary::view word = attributes.getWord(a);
+        hash = fnv1a(word.data(), word.size(), hash);
+        hash = fnv1a("", 1, hash);   // the zero byte after the name
+    }
+    hash = fnv1a("\xff", 1, hash);   // attributes and categories do not shift into each other
+    for(const std::string& c : categories) {
+        hash = fnv1a(c.c_str(), c.size() + 1, hash);   // with the zero byte after the name
+    }
+    return hash != 0 ? hash : 1;
+}
+
+/** \brief Count a training example.
+ * @param category id of the category of the example, 0 <= category < getCategoryCount()
+ * @param example ids of attributes present in the example, sorted and unique
+ */
+
+void CountTable::add(int category, const SparseExample& example) {
+    ++_examples[category];
+    int* row = _counts.data() + category * _attributes;
+    for(int a : example) {
+        ++row[a];
+    }
+}
+
+/** \brief Add the counters of another table.
+ * @param other table with the same categories and attributes
+ * @return false if the tables have different sizes or keys, nothing
+ *         is added then
+ */
+
+bool CountTable::merge(const CountTable& other) {
+    if(other._categories != _categories || other._attributes != _attributes) {
+        std::cerr << "Cannot merge count tables of different sizes" << std::endl;
+        return false;
+    }
+    if(other._key != _key) {
+        std::cerr << "Cannot merge count tables of different attributes or categories" << std::endl;
+        return false;
+    }
+    for(std::size_t c = 0; c < _categories; ++c) {
+        _examples[c] += other._examples[c];
+    }
+    for(std::size_t i = 0; i < _counts.size(); ++i) {
+        _counts[i] += other._counts[i];
+    }
+    return true;
+}
+
+/** \brief Write the table to a file.
+ * Only the non-zero attribute counters are written.
+ * @param filename name of the file to write
+ * @return false if the file cannot be written
+ */
+
+bool CountTable::save(const std::string& filename) const {
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.category_count = static_cast<std::uint32_t>(_categories);
+    h.attribute_count = static_cast<std::uint32_t>(_attributes);
+    h.key = _key;
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if(!output.is_open()) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    output.write(reinterpret_cast<const char*>(_examples.data()), _categories * sizeof(std::int32_t));
+
+    std::vector<std::uint32_t> entries;     // attribute, count, ...
+    for(std::size_t c = 0; c < _categories; ++c) {
+        const int* row = getCounts(c);
+        entries.clear();
+        for(std::size_t a = 0; a < _attributes; ++a) {
+            if(row[a] != 0) {
+                entries.push_back(static_cast<std::uint32_t>(a));
+                entries.push_back(static_cast<std::uint32_t>(row[a]));
+            }
+        }
+        std::uint32_t n = static_cast<std::uint32_t>(entries.size() / 2);
+        output.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(std::uint32_t));
+    }
+    return output.good();
+}
+
+/** \brief Read the table from a file written by save.
+ * @param filename name of the file
+ * @param key expected key of the table, 0 for any
+ * @return false if the file cannot be read, is not a valid counts
+ *         file or has another key, the table is left unchanged then
+ */
+
+bool CountTable::load(const std::string& filename, std::uint64_t key) {
+    std::ifstream input(filename, std::ios::binary);
+    if(!input.is_open()) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    Header h;
+    if(!input.read(reinterpret_cast<char*>(&h), sizeof(h))
+       || std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION) {
+        std::cerr << "Invalid counts file: " << filename << std::endl;
+        return false;
+    }
+    if(key != 0 && h.key != key) {
+        std::cerr << "Counts file of other attributes or categories: " << filename << std::endl;
+        return false;
+    }
+
+    CountTable table(h.category_count, h.attribute_count, h.key);
+    bool valid = static_cast<bool>(input.read(reinterpret_cast<char*>(table._examples.data()),
+                                              table._categories * sizeof(std::int32_t)));
+    std::vector<std::uint32_t> entries;
+    for(std::size_t c = 0; valid && c < table._categories; ++c) {
+        valid = table._examples[c] >= 0;
+        std::uint32_t n = 0;
+        if(!valid || !input.read(reinterpret_cast<char*>(&n), sizeof(n)) || n > table._attributes) {
+            valid = false;
+            break;
+        }
+        entries.resize(2 * n);
+        if(!input.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(std::uint32_t))) {
+            valid = false;
+            break;
+        }
+        int* row = table._counts.data() + c * table._attributes;
+        for(std::size_t i = 0; valid && i < n; ++i) {
+            std::uint32_t a = entries[2 * i];
+            std::uint32_t count = entries[2 * i + 1];
+            valid = a < table._attributes && count <= static_cast<std::uint32_t>(table._examples[c]);
+            if(valid)
+                row[a] = static_cast<int>(count);
+        }
+    }
+    if(!valid || input.peek() != std::ifstream::traits_type::eof()) {
+        std::cerr << "Invalid counts file: " << filename << std::endl;
+        return false;
+    }
+    *this = std::move(table);
+    return true;
+}
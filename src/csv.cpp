@@ -3,7 +3,7 @@
 //
 
 #include <bayesian_webclass/csv.h>
-#include <fstream>
+#include <bayesian_webclass/csv_reader.h>
 #include <iostream>
 
 
@@ -11,6 +11,7 @@
  *  Takes name of the csv file and numbers of the columns in the csv
  *  that will be used respectively as keys and values od the map.
  *  Keys should be type compatible with ints and values with strings.
+ *  The values are copied straight into the arena of the IdUrlMap.
  *  @param filename name of the csv file
  *  @param col1 csv column number holding keys for the map
  *  @param col2 csv column number holding values for the map
@@ -19,58 +20,61 @@
 
 bool Csv::csv2map(const std::string &filename,
         const int col1, const int col2) {
-    // Input stream to read the csv. Each line should hold one url.
-    std::ifstream url_csv(filename);
-    std::string::size_type sz; //needed to stoi -> string to int
+    bool success = readRecords(filename, col1, col2, [this](int id, CsvReader::view url) {
+        _id_url_map->add(id, url);
+        return true;
+    });
+    _id_url_map->sort(); //keeps the first url of a repeated id
+    return success;
+}
+
+/**  Reads (key, value) records from csv file given with the filename.
+ *  Every record is given to the callback as soon as its row is read, so
+ *  the records can be used before the whole file is parsed.
+ *  The file is read by the memory-mapped CsvReader. Rows with invalid ids
+ *  are skipped, up to _max_invalid_ids of them.
+ *  @param filename name of the csv file
+ *  @param col1 csv column number holding keys
+ *  @param col2 csv column number holding values
+ *  @param record called with the key and the value (a view valid during the call),
+ *  returns false to stop reading
+ *  @return boolean, true if the whole file was read
+ */
+
+bool Csv::readRecords(const std::string &filename, const int col1, const int col2,
+                      const RecordCallback &record) const {
+    // Each line should hold one url.
+    CsvReader url_csv;
     //key -> id of record in csv, value url name
 
-    if (url_csv.is_open()) {
-        std::string line;
-        boost::char_separator<char> sep{";"}; //used to tokenize csv row
+    if (url_csv.open(filename)) {
+        CsvReader::view line;
+        std::vector<CsvReader::view> fields;
 
-        getline(url_csv, line); //in first line are identifiers, don't need them
+        url_csv.nextLine(line); //in first line are identifiers, don't need them
         int max_col = (col1 > col2) ? col1 : col2;
         int counter_invalid_id = _max_invalid_ids; //number of ommited invalid ids
-        while (!url_csv.eof()) {
-            //tokenizing csv file line by line
-            getline(url_csv, line);
-            if (line == "") {
-                break;
-            }
-            t_tokenizer tok{line, sep};
-
-            int col_num = 0, id = 0;
-            std::string domain;
+        while (url_csv.nextLine(line) && !line.empty()) {
             if (counter_invalid_id < 0) {
                 std::cerr << "Too many invalid ids" << std::endl;
                 return false;
             }
 
-            try {
-                for (auto &t : tok) {
-                    if (col_num == col1) {  // Column of keys
-                        id = std::stoi(t, &sz);
-                    } else if (col_num == col2) {  // Column of values
-                        domain = t;
-                    } else if (col_num > max_col) {
-                        // No need to check later columns
-                        break;
-                    }
-                    ++col_num;
-                }
-            } catch (std::invalid_argument &) { //if std::stoi throws exeption, we ignore this row with invalid id
-                //   std::cerr << "invalid id, counter:" << counter_invalid_id<< std::endl;
+            // No need to split later columns
+            std::size_t col_num = url_csv.split(line, fields, max_col + 1);
+            int id = 0;
+            if (col_num > static_cast<std::size_t>(col1) && !CsvReader::parseInt(fields[col1], id)) {
+                //we ignore this row with invalid id
                 --counter_invalid_id;
                 continue;
             }
 
-            if (col_num <= max_col) {
+            if (col_num <= static_cast<std::size_t>(max_col)) {
                 //data from column_numbers and csv file doesn't match, csv hasn't enough columns
                 std::cerr << "Number of columns from csv file is smaller than values wanted" << std::endl;
-                //  std::cerr << "cols: " << col_num << "s: " << s << std::endl;
                 return false; //TODO jakos tu rzucac wyjatek
-            } else {
-                _id_url_map->insert(std::pair<int, std::string>(id, domain));
+            } else if (!record(id, fields[col2])) {
+                return false;
             }
         }
     } else {
@@ -78,7 +82,6 @@ bool Csv::csv2map(const std::string &filename,
             << std::endl;
         return false;
     }
-    url_csv.close();
     return true;
 }
 
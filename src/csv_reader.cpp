@@ -0,0 +1,162 @@
+#include <bayesian_webclass/csv_reader.h>
+#include <cctype>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/**Constructor
+ * @param delimiter character separating the fields
+ */
+CsvReader::CsvReader(char delimiter) : _data(nullptr), _size(0), _pos(nullptr), _delimiter(delimiter) {}
+
+/**Destructor
+ */
+CsvReader::~CsvReader() {
+    close();
+}
+
+/**Map the csv file into memory
+ * @param filename name of the csv file
+ * @return false if the file cannot be opened or mapped
+ */
+bool CsvReader::open(const std::string &filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        _data = static_cast<const char *>(data);
+        _size = st.st_size;
+    }
+    ::close(fd);    //the mapping stays valid after closing the descriptor
+    _pos = _data;
+    return true;
+}
+
+/**Unmap the file
+ */
+void CsvReader::close() {
+    if (_data) {
+        munmap(const_cast<char *>(_data), _size);
+    }
+    _data = _pos = nullptr;
+    _size = 0;
+}
+
+/**Get the next line of the file
+ * @param[out] line the line without '\n'
+ * @return false at the end of the file
+ */
+bool CsvReader::nextLine(view &line) {
+    const char *end = _data + _size;
+    if (_pos == end) {
+        return false;
+    }
+    const char *newline = find(_pos, end, '\n');
+    line = view(_pos, newline - _pos);
+    _pos = (newline == end) ? end : newline + 1;
+    return true;
+}
+
+/**Split the line into fields
+ * Empty fields are skipped, as boost::char_separator does.
+ * @param[in] line line of the file
+ * @param[out] fields views of the fields
+ * @param[in] max_fields the line is split only up to this number of fields
+ * @return number of fields
+ */
+std::size_t CsvReader::split(view line, std::vector<view> &fields, std::size_t max_fields) const {
+    fields.clear();
+    const char *p = line.data();
+    const char *end = p + line.size();
+    while (p < end && fields.size() < max_fields) {
+        const char *next = find(p, end, _delimiter);
+        if (next > p) {
+            fields.push_back(view(p, next - p));
+        }
+        if (next == end) {
+            break;
+        }
+        p = next + 1;
+    }
+    return fields.size();
+}
+
+/**Find the character
+ * 16 bytes are compared at once with SSE2.
+ * @param begin start of the searched range
+ * @param end end of the searched range
+ * @param c character to find
+ * @return pointer to the first c, end if there is none
+ */
+const char *CsvReader::find(const char *begin, const char *end, char c) {
+#ifdef __SSE2__
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - begin >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 16;
+    }
+#endif
+    while (begin < end && *begin != c) {
+        ++begin;
+    }
+    return begin;
+}
+
+/**Parse an integer like std::stoi
+ * Leading white space and a sign are allowed, the field must start with
+ * a digit after them, characters after the digits are ignored.
+ * @param[in] field text of the field
+ * @param[out] value parsed number
+ * @return false if there is no number or it does not fit in int
+ */
+bool CsvReader::parseInt(view field, int &value) {
+    const char *p = field.data();
+    const char *end = p + field.size();
+    while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    long long number = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        number = number * 10 + (*p - '0');
+        if (number > static_cast<long long>(INT_MAX) + 1) {
+            return false;
+        }
+    }
+    number = negative ? -number : number;
+    if (number > INT_MAX || number < INT_MIN) {
+        return false;
+    }
+    value = static_cast<int>(number);
+    return true;
+}
@@ -1,46 +1,133 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include <boost/filesystem/operations.hpp>
 #include "bayesian_webclass/data_preprocessor.h"
+#include "bayesian_webclass/page_pipeline.h"
+#include "bayesian_webclass/bounded_queue.h"
 
 /**Constructor
  * @param curl_out_folder folder in which output of data preprocessing will be stored
  */
-DataPreprocessor::DataPreprocessor(std::string curl_out_folder) : ptr_csv(new Csv()), ptr_http(new HTTPDownloader()),
-                                                                  _curl_output_folder(curl_out_folder), fileCounter(0){}
+DataPreprocessor::DataPreprocessor(std::string curl_out_folder) : ptr_csv(new Csv()),
+                                                                  _curl_output_folder(curl_out_folder), fileCounter(0),
+                                                                  all_atribs(std::make_shared<Vocabulary>()),
+                                                                  _session(std::make_shared<DownloadSession>()),
+                                                                  ptr_http(new HTTPDownloader(_session)),
+                                                                  ptr_async(new AsyncDownloader(32, 8, 5, _session)){}
+
+/** Keep downloaded pages in the on-disk cache
+ * Both downloaders take pages from the cache, so repeated runs (e.g. retraining)
+ * do not download them again and can work offline.
+ * @param directory directory of the cache
+ * @param max_age time in seconds after which a page is revalidated, negative - never
+ */
+void DataPreprocessor::setCache(const std::string &directory, long max_age) {
+    ptr_cache.reset(new PageCache(directory, max_age));
+    ptr_http->setCache(ptr_cache.get());
+    ptr_async->setCache(ptr_cache.get());
+}
 
 /** Filter domains that return quick http response
  * Filer domains that give http reponse in less than 5 seconds and save them
- * in "output_filename" file
+ * in "output_filename" file. The csv file is read by a producer thread into
+ * a bounded queue while links are downloaded concurrently by ptr_async, so
+ * the first requests go out at once and memory does not grow with the file.
+ * The download loop takes records without waiting and is woken up by the
+ * reader, so a slow reader does not stall the running transfers.
+ * Every line is checked, also when its id was already seen (csv2map kept
+ * the first url of an id, which needs memory for all ids).
+ * Results are written as they complete, or in the order of the input file
+ * if keep_order is set (finished results wait for the earlier ones); for
+ * a file sorted by id, as the exported lists are, this is the id order of
+ * csv2map, other files are not sorted.
+ * In DOWNLOAD_PAGES mode the valid domains are saved as "id;url".
+ * In CHECK_LIVENESS mode only HEAD requests are sent (see AsyncDownloader::check)
+ * and every domain is saved: "id;url;status;latency_ms", status 0 if the server did not answer.
  * @param input_filename name of file with links, every link in other line
  * @param output_filename links that can be opened will be stored in this file
+ * @param mode how the domains are checked
+ * @param keep_order save the results in the order of the input file
  * @return false is cannot open file, otherwise return true
  */
-bool DataPreprocessor::filterValidDomains(const std::string &input_filename, const std::string &output_filename) {
+bool DataPreprocessor::filterValidDomains(const std::string &input_filename, const std::string &output_filename,
+                                          FilterMode mode, bool keep_order) {
+    typedef std::pair<int, std::string> Record;
+    const std::size_t max_running = 128;      //records being checked at once
+    const std::size_t max_waiting = 4096;     //finished records waiting for an earlier one in keep_order
 
-    int csv_columns[2] = {0, 1};
-    bool success = this->ptr_csv->csv2map(input_filename, csv_columns[0],csv_columns[1]);
-    Csv::map::iterator map_it;
-    bool is_downloadable = true;
-    int good_links = 0, all_links = 0; //counter of usable links
     std::ofstream valid_domains_file;
     valid_domains_file.open(output_filename);
     if (!valid_domains_file.is_open()) //invalid file
     {
         return false;
-    } else {
-        for (map_it = ptr_csv->getId_url_map()->begin(); map_it != ptr_csv->getId_url_map()->end(); ++map_it) {
-            std::cout << map_it->first << "  " << map_it->second << std::endl << std::flush;
-            all_links++;
-            std::string a;
-            is_downloadable = this->ptr_http->download(map_it->second, a);
-
-            if (is_downloadable) {
-                valid_domains_file << map_it->first << ";" << map_it->second << "\n";
-                ++good_links;
+    }
+
+    BoundedQueue<Record> records(1024);
+    bool success = false;
+    std::thread reader([this, &input_filename, &records, &success]() {
+        success = ptr_csv->readRecords(input_filename, 0, 1, [this, &records](int id, CsvReader::view url) {
+            bool pushed = records.push(Record(id, url.to_string()));
+            ptr_async->wakeup();
+            return pushed;
+        });
+        records.close();
+        ptr_async->wakeup();
+    });
+
+    int good_links = 0, all_links = 0; //counter of usable links
+    std::size_t running = 0, next_record = 0, next_to_write = 0;
+    std::map<std::size_t, std::string> finished; //reorder stage, results by record number
+    auto write = [&](std::size_t number, const std::string &line) {
+        --running;
+        if (!keep_order) {
+            valid_domains_file << line << std::flush;
+            return;
+        }
+        finished[number] = line;
+        for (auto it = finished.begin(); it != finished.end() && it->first == next_to_write; it = finished.erase(it)) {
+            valid_domains_file << it->second;
+            ++next_to_write;
+        }
+        valid_domains_file.flush();
+    };
+    std::function<void()> refill = [&]() {
+        Record record;
+        while (running < max_running && (!keep_order || next_record - next_to_write < max_waiting)
+               && records.tryPop(record)) {
+            std::size_t number = next_record++;
+            int id = record.first;
+            ++running;
+            ++all_links;
+            if (mode == CHECK_LIVENESS) {
+                ptr_async->check(record.second, [&, number, id](const std::string &url, long status, double seconds) {
+                    std::ostringstream line;
+                    line << id << ";" << url << ";" << status << ";" << static_cast<long>(seconds * 1000 + 0.5) << "\n";
+                    good_links += (status >= 200 && status < 400);
+                    write(number, line.str());
+                    refill();
+                });
+            } else {
+                ptr_async->add(record.second, [&, number, id](const std::string &url, bool ok, std::string &) {
+                    std::cout << url << (ok ? "  ok" : "  failed") << std::endl << std::flush;
+                    good_links += ok;
+                    write(number, ok ? std::to_string(id) + ";" + url + "\n" : std::string());
+                    refill();
+                });
             }
         }
-        valid_domains_file.close();
+    };
+    ptr_async->run([&]() {
+        refill();
+        return !records.drained();
+    });
+    reader.join();
+    valid_domains_file.close();
+
+    if (mode == CHECK_LIVENESS) {
+        std::cout << "All links: " << all_links << "\nLive links: " << good_links << std::endl << std::flush;
+    } else {
         double prc = good_links / (double) all_links;
         prc = prc * 100;
 
@@ -53,6 +140,8 @@ bool DataPreprocessor::filterValidDomains(const std::string &input_filename, con
 /**Parse html code.
  * Parse html code from all links in filename. Html code is parsed depending on fromWhickTags parameter
  * which is a
+ * Links are downloaded concurrently by ptr_async, every downloaded page goes through
+ * the in-memory PagePipeline as soon as it arrives and results are saved in the order of the file.
 *@param filename - file where html code is
 *@param from_which_tags - from which tags from html (or xml) code structure the content should be
  */
@@ -60,55 +149,51 @@ bool DataPreprocessor::parseHtmls(const std::string &filename,
                                   const std::string &from_which_tags) {
     //get html addresses from textfile to vector of string
     string_vec addresses = ptr_http->getLinesFromFile(filename + ".txt");
-    std::string html_text, file_path;
+    std::string file_path;
     std::string path_root(this->_curl_output_folder + "/");
 
     bool success = false;
     boost::filesystem::create_directories(this->_curl_output_folder); //create a directory for results
-    int count = 0;
-    for (std::string i : addresses) {
-        html_text = "";
-        success = ptr_http->download(i, html_text); //for every link from file download the html code
+    if (addresses.size() > 21) {
+        addresses.resize(21); //only the first links are parsed
+    }
+    const PagePipeline pipeline = PagePipeline::createLinkPipeline(from_which_tags);
+    std::vector<Page> pages(addresses.size());
+    std::vector<char> parsed(addresses.size(), 0);
+    for (std::size_t i = 0; i < addresses.size(); ++i) {
+        ptr_async->add(addresses[i], [&pipeline, &pages, &parsed, i](const std::string &url, bool ok,
+                                                                     std::string &body) {
+            if (ok) {
+                pages[i].url = url;
+                pages[i].html.swap(body);
+                parsed[i] = pipeline.process(pages[i]);
+                pages[i].html.clear();
+                pages[i].html.shrink_to_fit(); //only the attributes are kept
+            }
+        });
+    }
+    ptr_async->run();
+
+    for (std::size_t i = 0; i < addresses.size(); ++i) {
+        success = parsed[i];
         if (!success) {
             break;
         }
-        file_path = path_root + "tmp.txt";
-        ptr_http->writeStrToFile(file_path, html_text);
-        std::string line, line1;
-        std::ifstream ifs(file_path);
-        html_text = "";
         file_path = path_root + std::to_string(this->fileCounter) + ".txt";
-        while (!ifs.eof()) {
-            getline(ifs, line);
-
-            while (line.back() != '>') {
-                if (!ifs.eof()) {
-                    getline(ifs, line1);
-                    line += line1;
-                } else {
-                    break;//TODO cos tu sie zapetla, trzeba naprawic
-                }
-            }
-            html_text += line;
-            html_text += '\n';
-        }
-
         std::string output_of_parsing(filename + "\n");
         output_of_parsing.erase(0,11); //erase train_data
-        std::set<std::string> map_of_attribs;
-        ptr_http->parseHtmlAndSave(html_text, from_which_tags,
-                                   output_of_parsing,
-                                   map_of_attribs);  //parse html_text and save to file in /output directory text from "html/body" node, that means only the text between <body></body>
-        all_atribs.insert(map_of_attribs.begin(), map_of_attribs.end());
+        for (const std::string &attrib : pages[i].attribs) {
+            output_of_parsing += attrib;
+            output_of_parsing += '\n';
+        }
+        for (const std::string &attrib : pages[i].attribs) {
+            all_atribs->add(attrib);
+        }
         ptr_http->writeStrToFile(file_path, output_of_parsing); //write to file parsed html
 
         this->fileCounter++;
-        count++;
-        if(count>20){
-            break;
-        }
     }
-   std::cout << "All attributes" << all_atribs.size() << std::endl;
+   std::cout << "All attributes" << all_atribs->size() << std::endl;
     return success;
 }
 
@@ -165,10 +250,10 @@ void DataPreprocessor::chooseTrainData(const std::string &inFilename) {
 }
 
 /**Getter
- *
+ * The vocabulary can be shared, e.g. by a Dictionary.
  * @return allAttribs
  */
-const std::set<std::string> &DataPreprocessor::getAll_atribs() const {
+std::shared_ptr<const Vocabulary> DataPreprocessor::getAll_atribs() const {
     return all_atribs;
 }
 
@@ -180,45 +265,50 @@ const std::set<std::string> &DataPreprocessor::getAll_atribs() const {
  * @return true - all went good, false - cannot open article/ no internet connection
  */
 bool DataPreprocessor::get_attribs_from_link(const std::string &url) {
-    std::string html_text, file_path;
-    std::string path_root("example/");
-    std::string from_which_tags("/html/body/div[@id='content']/div[@id='bodyContent']/div[@id='mw-content-text']/p");
-    bool success = false;
-    boost::filesystem::create_directories("example"); //create a directory for results
-    html_text = "";
-    success = ptr_http->download(url, html_text); //for every link from file download the html code
-    if (!success) {
+    std::set<std::string> map_of_attribs;
+    if (!get_attribs_from_link(url, map_of_attribs)) {
         return false;
     }
-    file_path = path_root + "tmp.txt";
-    ptr_http->writeStrToFile(file_path, html_text);
-    std::string line, line1;
-    std::ifstream ifs(file_path);
-    html_text = "";
-    file_path = path_root + "attribs.txt";
-    while (!ifs.eof()) { //prepare code for parsing
-        getline(ifs, line);
-
-        while (line.back() != '>') {
-            if (!ifs.eof()) {
-                getline(ifs, line1);
-                line += line1;
-            } else {
-                break;
-            }
-        }
-        html_text += line;
-        html_text += '\n';
-    }
-
+    boost::filesystem::create_directories("example"); //create a directory for results
     std::string output_of_parsing;
-    std::set<std::string> map_of_attribs;
-    ptr_http->parseHtmlAndSave(html_text, from_which_tags,
-                                output_of_parsing,
-                                map_of_attribs);  //parse html_text and save to file in /output directory text from "html/body" node, that means only the text between <body></body>
-    ptr_http->writeStrToFile(file_path, output_of_parsing); //write to file parsed html
-    return success;
+    for (const std::string &i : map_of_attribs) {
+        output_of_parsing += i;
+        output_of_parsing += '\n';
+    }
+    ptr_http->writeStrToFile("example/attribs.txt", output_of_parsing); //write to file parsed html
+    return true;
 }
 
+/**Get attributes from wiki link into memory
+ * Same as get_attribs_from_link(url) but nothing is written to disk,
+ * attributes are returned in the given set.
+ * @param[in] url url address of en.wikipedia.org article
+ * @param[out] attribs attributes (links found in text of article)
+ * @return true - all went good, false - cannot open article/ no internet connection
+ */
+bool DataPreprocessor::get_attribs_from_link(const std::string &url, std::set<std::string> &attribs) {
+    return get_attribs_from_link(*ptr_http, url, attribs);
+}
 
-
+/**Get attributes from wiki link into memory, with the given downloader
+ * Same as get_attribs_from_link(url, attribs) but needs no DataPreprocessor,
+ * so callers in many threads can download with their own downloaders.
+ * @param[in] http downloader used for the article, only by this call
+ * @param[in] url url address of en.wikipedia.org article
+ * @param[out] attribs attributes (links found in text of article)
+ * @return true - all went good, false - cannot open article/ no internet connection
+ */
+bool DataPreprocessor::get_attribs_from_link(HTTPDownloader &http, const std::string &url,
+                                             std::set<std::string> &attribs) {
+    static const PagePipeline pipeline = PagePipeline::createLinkPipeline(
+            "/html/body/div[@id='content']/div[@id='bodyContent']/div[@id='mw-content-text']/p");
+    Page page;
+    page.url = url;
+    if (!http.download(url, page.html)) {
+        return false;
+    }
+    page.attribs.swap(attribs);
+    bool success = pipeline.process(page); //only the links from mw-content-text paragraphs
+    attribs.swap(page.attribs);
+    return success;
+}
@@ -42,14 +42,9 @@ void Dictionary::write_str_to_file(std::string filename, std::string str) {
  */
 
 void Dictionary::fetch_from_file(std::string filename) {
-    word_list.clear();
-    std::ifstream input;
-    input.open(filename);
-    std::string word;
-
-    while(input >> word) {
-        word_list.push_back(word);
-    }
+    std::shared_ptr<Vocabulary> words = std::make_shared<Vocabulary>();
+    words->load(filename);
+    word_list = words;      // a shared vocabulary is left unchanged
 }
 
 /** \brief Compare words in given file with the current word_list.
@@ -60,19 +55,18 @@ void Dictionary::fetch_from_file(std::string filename) {
  */
 
 int Dictionary::compare(const std::string& filename) {
-    std::map<std::string, int> wordCnt;
+    std::vector<char> matched(word_list->size(), 0);
     std::ifstream input;
     input.open(filename);
     std::string word;
 
-    while(input >> word) {
-        ++wordCnt[word];
-    }
-
     int matchedCnt = 0;
-    for(auto w : word_list) {
-        if(wordCnt.count(w))
+    while(input >> word) {
+        int id = word_list->find(word);
+        if(id >= 0 && !matched[id]) {
+            matched[id] = 1;
             ++matchedCnt;
+        }
     }
 
     return matchedCnt;
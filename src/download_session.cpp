@@ -0,0 +1,68 @@
+#include "bayesian_webclass/download_session.h"
+#include "curl/curl.h"
+
+
+/**Lock the shared data of the given kind
+ */
+static void lockShare(CURL *, curl_lock_data data, curl_lock_access, void *locks) {
+    static_cast<std::mutex *>(locks)[data].lock();
+}
+
+/**Unlock the shared data of the given kind
+ */
+static void unlockShare(CURL *, curl_lock_data data, void *locks) {
+    static_cast<std::mutex *>(locks)[data].unlock();
+}
+
+/**Create the share handle, initializing libcurl on first use
+ * curl_global_init is not thread safe, so it runs once per process,
+ * before the first handle, whichever thread creates the first session.
+ */
+static CURLSH *createShare() {
+    static std::once_flag flag;
+    std::call_once(flag, [] { curl_global_init(CURL_GLOBAL_ALL); });
+    return curl_share_init();
+}
+
+/**Constructor
+ * Creates the share handle with DNS cache and TLS sessions. Connections stay
+ * in the connection cache of each handle, sharing them between threads is
+ * not supported by curl.
+ */
+DownloadSession::DownloadSession() : _share(createShare()), _locks(new std::mutex[CURL_LOCK_DATA_LAST]) {
+    curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(_share, CURLSHOPT_USERDATA, _locks.get());
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+/**Destructor
+ * Handles configured by the session must be cleaned up before.
+ */
+DownloadSession::~DownloadSession() {
+    curl_share_cleanup(_share);
+}
+
+/**Set up the curl easy handle to use the session
+ * A transfer of a https url waits for a connection to the host being set up
+ * instead of opening another one, so it can be multiplexed over HTTP/2.
+ * Plain http stays on HTTP/1.1, where waiting would only serialise the transfers.
+ * @param easy curl easy handle
+ * @param url url of the transfer run concurrently with others, empty for a single handle
+ */
+void DownloadSession::configure(void *easy, const std::string &url) const {
+    curl_easy_setopt(easy, CURLOPT_SHARE, _share);
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS); //HTTP/2 over https, HTTP/1.1 otherwise
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, url.compare(0, 8, "https://") == 0 ? 1L : 0L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, ""); //every encoding curl was built with
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L); //Prevent "longjmp causes uninitialized stack frame" bug
+}
+
+/**Set up the curl multi handle to multiplex the transfers of the session
+ * @param multi curl multi handle
+ */
+void DownloadSession::configureMulti(void *multi) const {
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+}
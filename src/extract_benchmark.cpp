@@ -0,0 +1,80 @@
+#include <bayesian_webclass/page_pipeline.h>
+#include <bayesian_webclass/async_downloader.h>
+#include <bayesian_webclass/http_downloader.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+int main(int argc, char* argv[]) {  //compares link extraction with the fast tokenizer, libxml2 SAX and libtidy
+
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " page.html... | urls.txt..." << std::endl;
+        std::cerr << "  .txt files are lists of urls (e.g. txt/html/http_addresses.txt), downloaded first" << std::endl;
+        return 1;
+    }
+    const std::string path("/html/body/div[@id='content']/div[@id='bodyContent']/div[@id='mw-content-text']/p");
+    const int repeats = 5;
+
+    std::vector<std::string> pages;
+    AsyncDownloader downloader;
+    for (int i = 1; i < argc; ++i) {
+        std::string name(argv[i]);
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0) {
+            for (const std::string &url : HTTPDownloader().getLinesFromFile(name)) {
+                if (!url.empty()) {
+                    downloader.add(url, [&pages](const std::string &, bool ok, std::string &body) {
+                        if (ok) {
+                            pages.push_back(std::string());
+                            pages.back().swap(body);
+                        }
+                    });
+                }
+            }
+        } else {
+            std::ifstream input(name);
+            std::stringstream buffer;
+            buffer << input.rdbuf();
+            pages.push_back(buffer.str());
+        }
+    }
+    downloader.run();
+    for (std::string &html : pages) {
+        Page page;
+        page.html.swap(html);
+        PreparePageStage().process(page);
+        html.swap(page.html);
+    }
+    std::cout << "Pages: " << pages.size() << std::endl;
+
+    LinkExtractor extractor(path);
+    TidyEventSource tidy;
+    SaxEventSource sax;
+    TokenizerEventSource tokenizer;
+    std::vector<std::set<std::string>> reference(pages.size());
+    const std::pair<const char *, const HtmlEventSource *> sources[] = {{"tidy", &tidy}, {"sax", &sax},
+                                                                        {"tokenizer", &tokenizer}};
+    for (const auto &source : sources) {
+        int failed = 0, different = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            for (std::size_t i = 0; i < pages.size(); ++i) {
+                std::set<std::string> links;
+                bool ok = extractor.extract(pages[i], links, *source.second);
+                if (r == 0) {
+                    if (source.second == &tidy) {
+                        reference[i] = links;
+                    }
+                    failed += !ok;
+                    different += ok && links != reference[i];
+                }
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << source.first << ": " << ms / repeats << " ms per run, "
+                  << (pages.empty() ? 0.0 : ms / repeats / pages.size()) << " ms per page, "
+                  << failed << " failed, " << different << " different from tidy" << std::endl;
+    }
+    return 0;
+}
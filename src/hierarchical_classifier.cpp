@@ -0,0 +1,295 @@
+#include "bayesian_webclass/hierarchical_classifier.h"
+#include "bayesian_webclass/classifier.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+/** \brief Constructor.
+ * Creates a tree with the root only, use init or loadTree and train.
+ */
+
+HierarchicalClassifier::HierarchicalClassifier() {
+    addNode("");
+}
+
+/** \brief Method for classifier initialization.
+ * Loads the attributes, categories and tree, counts the examples
+ * in the given directory (as Classifier::init, in many threads) and
+ * trains the models of the nodes.
+ * @param attributes name of the file listing all attributes
+ * @param categories name of the file listing all categories
+ * @param tree name of the file with "parent child" pairs
+ * @param examples_dir directory containing examples
+ * @param examples_num number of examples to be used
+ * @param threads number of threads reading the examples, 0 for the
+ *        number of hardware threads
+ * @return false if an example cannot be read or has an unknown
+ *         category, or the tree is not valid; the classifier is not
+ *         trained then
+ */
+
+bool HierarchicalClassifier::init(const std::string& attributes,
+                                  const std::string& categories,
+                                  const std::string& tree,
+                                  const std::string& examples_dir,
+                                  int examples_num,
+                                  unsigned threads) {
+    Classifier flat;
+    flat.loadAttributes(attributes);
+    flat.loadCategories(categories);
+
+    CountTable counts;
+    if(!flat.countExamples(examples_dir, 0, examples_num, counts, threads))
+        return false;
+    std::vector<std::string> names;
+    for(std::size_t c = 0; c < counts.getCategoryCount(); ++c) {
+        names.push_back(flat.getCategoryName(c));
+    }
+    return loadTree(tree, names) && train(flat.getVocabulary(), counts);
+}
+
+/** \brief Method loading the category tree.
+ * Every line of the file is a "parent child" pair of names. A child
+ * has one parent; names without children have to be categories.
+ * Categories which are not in the file hang from the root.
+ * @param tree name of the file with the tree
+ * @param categories names of the categories, in the order of the
+ *        training counters
+ * @return false if the file cannot be read or is not a tree
+ */
+
+bool HierarchicalClassifier::loadTree(const std::string& tree,
+                                      const std::vector<std::string>& categories) {
+    _nodes.clear();
+    _index.clear();
+    _categories = categories;
+    addNode("");
+
+    std::ifstream input(tree);
+    if(!input.is_open()) {
+        std::cerr << "Cannot open category tree: " << tree << std::endl;
+        return false;
+    }
+    std::string line;
+    while(std::getline(input, line)) {
+        std::istringstream pair(line);
+        std::string parent, child;
+        if(!(pair >> parent))
+            continue;   // empty line
+        if(!(pair >> child)) {
+            std::cerr << "Category tree line without child: " << line << std::endl;
+            return false;
+        }
+        const int p = addNode(parent);
+        const int c = addNode(child);
+        if(_nodes[c].parent >= 0 || p == c) {
+            std::cerr << "Category with many parents: " << child << std::endl;
+            return false;
+        }
+        _nodes[c].parent = p;
+        _nodes[p].children.push_back(c);
+    }
+    for(std::size_t c = 0; c < categories.size(); ++c) {
+        _nodes[addNode(categories[c])].category = static_cast<int>(c);
+    }
+    for(std::size_t n = 1; n < _nodes.size(); ++n) {
+        if(_nodes[n].parent < 0) {
+            _nodes[n].parent = 0;
+            _nodes[0].children.push_back(n);
+        }
+    }
+
+    std::size_t reached = 0;    // nodes in a cycle are not reached from the root
+    std::vector<int> stack(1, 0);
+    while(!stack.empty()) {
+        const Node& node = _nodes[stack.back()];
+        stack.pop_back();
+        ++reached;
+        if(node.children.empty() && node.category < 0 && &node != &_nodes[0]) {
+            std::cerr << "Category tree leaf is not a category: " << node.name << std::endl;
+            return false;
+        }
+        stack.insert(stack.end(), node.children.begin(), node.children.end());
+    }
+    if(reached != _nodes.size()) {
+        std::cerr << "Category tree has a cycle" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** \brief Method training the models of the nodes.
+ * The counters of a branch are the sums of the counters of the
+ * categories below it; the log-probabilities are those of
+ * faif::ml::NaiveBayesian with binary attributes.
+ * @param vocabulary attribute ids, shared e.g. with a Classifier
+ * @param counts training counters of the categories of loadTree
+ * @return false if the counters do not match the categories
+ */
+
+bool HierarchicalClassifier::train(std::shared_ptr<const Vocabulary> vocabulary,
+                                   const CountTable& counts) {
+    if(!vocabulary || counts.getCategoryCount() != _categories.size()
+       || counts.getAttributeCount() != vocabulary->size()
+       || counts.getKey() != CountTable::makeKey(*vocabulary, _categories)) {
+        std::cerr << "Counts do not match attributes and categories" << std::endl;
+        return false;
+    }
+    _vocabulary = vocabulary;
+    const std::size_t A = counts.getAttributeCount();
+
+    for(std::size_t n = 0; n < _nodes.size(); ++n) {
+        Node& node = _nodes[n];
+        node.branches = node.children;
+        if(node.category >= 0)
+            node.branches.push_back(n);     // stop at the node
+        node.model.reset();
+        if(node.branches.size() < 2)
+            continue;
+
+        const std::size_t B = node.branches.size();
+        std::vector<double> examples(B, 0.0);
+        std::vector<double> present(B * A, 0.0);   // [branch][attribute]
+        std::vector<int> below;
+        for(std::size_t b = 0; b < B; ++b) {
+            below.clear();
+            if(node.branches[b] == static_cast<int>(n))
+                below.push_back(node.category);
+            else
+                subtreeCategories(node.branches[b], below);
+            for(int c : below) {
+                examples[b] += counts.getExamples(c);
+                const int* row = counts.getCounts(c);
+                for(std::size_t a = 0; a < A; ++a)
+                    present[b * A + a] += row[a];
+            }
+        }
+
+        double all = 0.0;
+        for(double e : examples)
+            all += e;
+        std::vector<double> category_log_prob(B);
+        std::vector<double> value_log_prob(B * 2 * A);  // [branch][attribute][absent, present]
+        for(std::size_t b = 0; b < B; ++b) {
+            category_log_prob[b] = std::log((examples[b] + 1.0) / (all + B));
+            const double denominator = std::log(examples[b] + 2.0);
+            for(std::size_t a = 0; a < A; ++a) {
+                const double p = present[b * A + a];
+                value_log_prob[b * 2 * A + 2 * a] = std::log(examples[b] - p + 1.0) - denominator;
+                value_log_prob[b * 2 * A + 2 * a + 1] = std::log(p + 1.0) - denominator;
+            }
+        }
+        node.model.reset(new BernoulliModel());
+        node.model->build(A, B, category_log_prob.data(), value_log_prob.data(), 2 * A);
+    }
+    return true;
+}
+
+/** \brief Method classifying a test example given in memory.
+ * Descends the tree keeping the beam most probable paths; the
+ * probability of a branch is normalized over the branches of its
+ * node, so paths through different nodes are comparable.
+ * @param attribs set of attributes (links) found in the example
+ * @param beam number of paths kept at every level, 1 for greedy
+ * @return name of the most probable category, empty if the
+ *         classifier is not trained
+ */
+
+std::string HierarchicalClassifier::classify(const std::set<std::string>& attribs,
+                                             std::size_t beam) const {
+    if(!_vocabulary)
+        return "";
+    SparseExample ex;
+    for(const std::string& word : attribs) {
+        int id = _vocabulary->find(word);
+        if(id >= 0)
+            ex.push_back(id);
+    }
+    std::sort(ex.begin(), ex.end());
+
+    struct Path {
+        int node;
+        double log_prob;
+        bool done;      // the category of the node is the result
+    };
+    auto better = [](const Path& a, const Path& b) { return a.log_prob > b.log_prob; };
+    beam = std::max<std::size_t>(beam, 1);
+
+    std::vector<Path> paths(1, Path{0, 0.0, _nodes[0].children.empty()});
+    std::vector<Path> next;
+    std::vector<double> scores;
+    while(std::any_of(paths.begin(), paths.end(), [](const Path& p) { return !p.done; })) {
+        next.clear();
+        for(const Path& path : paths) {
+            const Node& node = _nodes[path.node];
+            if(path.done) {
+                next.push_back(path);
+                continue;
+            }
+            scores.assign(node.branches.size(), 1.0);
+            if(node.model) {
+                node.model->score(ex, &scores[0]);
+                faif::ml::normalizeLogProbabilities(&scores[0], scores.size());
+            }
+            for(std::size_t b = 0; b < node.branches.size(); ++b) {
+                const int child = node.branches[b];
+                const bool done = child == path.node || _nodes[child].children.empty();
+                next.push_back(Path{child, path.log_prob + std::log(scores[b]), done});
+            }
+        }
+        std::size_t keep = std::min(beam, next.size());
+        std::partial_sort(next.begin(), next.begin() + keep, next.end(), better);
+        next.resize(keep);
+        paths.swap(next);
+    }
+    const Node& best = _nodes[std::min_element(paths.begin(), paths.end(), better)->node];
+    return best.category >= 0 ? _categories[best.category] : "";
+}
+
+/** \brief Method giving the depth of the tree.
+ * @return number of edges on the longest path from the root
+ */
+
+std::size_t HierarchicalClassifier::getDepth() const {
+    std::size_t depth = 0;
+    for(std::size_t n = 0; n < _nodes.size(); ++n) {
+        std::size_t d = 0;
+        for(int p = _nodes[n].parent; p >= 0; p = _nodes[p].parent)
+            ++d;
+        depth = std::max(depth, d);
+    }
+    return depth;
+}
+
+/** \brief Method giving the node of a name, added if not found.
+ * @param name name of the category or group
+ * @return index of the node
+ */
+
+int HierarchicalClassifier::addNode(const std::string& name) {
+    std::map<std::string, int>::const_iterator it = _index.find(name);
+    if(it != _index.end())
+        return it->second;
+    Node node;
+    node.name = name;
+    node.category = -1;
+    node.parent = -1;
+    _nodes.push_back(std::move(node));
+    _index[name] = _nodes.size() - 1;
+    return _nodes.size() - 1;
+}
+
+/** \brief Method giving the categories of a subtree.
+ * @param[in] node root of the subtree
+ * @param[out] categories the categories are appended
+ */
+
+void HierarchicalClassifier::subtreeCategories(int node, std::vector<int>& categories) const {
+    if(_nodes[node].category >= 0)
+        categories.push_back(_nodes[node].category);
+    for(int child : _nodes[node].children)
+        subtreeCategories(child, categories);
+}
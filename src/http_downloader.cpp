@@ -13,10 +13,12 @@
 
 
 /**Constructor
- *
+ * @param session connection state shared with other downloaders, a new one if empty
  */
-HTTPDownloader::HTTPDownloader() {
+HTTPDownloader::HTTPDownloader(std::shared_ptr<DownloadSession> session)
+        : _cache(nullptr), _session(session ? session : std::make_shared<DownloadSession>()) {
     curl = curl_easy_init();
+    _session->configure(curl);
 }
 
 /**Destructor
@@ -26,30 +28,94 @@ HTTPDownloader::~HTTPDownloader() {
     curl_easy_cleanup(curl);
 }
 
-std::size_t write_data(void *ptr, std::size_t size, std::size_t nmemb, void *stream) {
-    std::string data((const char *) ptr, (std::size_t) size * nmemb);
-    *((std::stringstream *) stream) << data << std::endl;
+/** Destination of the downloaded body
+ */
+struct WriteBuffer {
+    void *curl;
+    std::string *output;
+    bool reserved;
+};
+
+/**Append the received chunk directly to the output string
+ * On the first chunk the output is reserved for the whole body,
+ * if the server sent Content-Length. For a compressed response it is
+ * the compressed size, a lower bound of the decoded body.
+ */
+static std::size_t write_data(void *ptr, std::size_t size, std::size_t nmemb, void *stream) {
+    WriteBuffer *buffer = static_cast<WriteBuffer *>(stream);
+    if (!buffer->reserved) {
+        curl_off_t length = -1;
+        if (curl_easy_getinfo(buffer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK && length > 0) {
+            buffer->output->reserve(buffer->output->size() + static_cast<std::size_t>(length));
+        }
+        buffer->reserved = true;
+    }
+    buffer->output->append(static_cast<const char *>(ptr), size * nmemb);
     return size * nmemb;
 }
+
+/**Set the page cache
+ * @param cache cache used by download, must outlive the downloader; nullptr - no cache
+ */
+void HTTPDownloader::setCache(const PageCache *cache) {
+    _cache = cache;
+}
+
 /**Download html code
 * Downloads html text from given website, waits 5 seconds for response
-* otherwise returns false
+* otherwise returns false. The body is written by curl directly
+* at the end of output, without intermediate copies.
+* If a cache is set, a fresh cached page is returned without downloading,
+* a stale one is revalidated with a conditional request and used
+* when the server answers 304 or cannot be reached.
 * @param[in] url - url address of website to curl
-* @param[out] output - html code from given url will be saved here
+* @param[out] output - html code from given url will be appended here
 * @return true if everything went right, false if not
 */
 bool HTTPDownloader::download(const std::string &url,
                               std::string &output) {
+    PageCache::Entry entry;
+    const bool cached = _cache && _cache->lookup(url, entry);
+    if (cached && _cache->isFresh(entry)) {
+        output += entry.body;
+        return true;
+    }
+    struct curl_slist *request_headers = nullptr;
+    if (cached) {
+        for (const std::string &header : PageCache::conditionalHeaders(entry)) {
+            request_headers = curl_slist_append(request_headers, header.c_str());
+        }
+    }
+
+    std::string body;
+    PageCache::ResponseHeaders response_headers;
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L); //wait for website response max 5s
-    std::stringstream out;
+    WriteBuffer buffer = {curl, _cache ? &body : &output, false};
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1); //Prevent "longjmp causes uninitialized stack frame" bug
-    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "deflate");
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &out);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, PageCache::headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request_headers);
     CURLcode res = curl_easy_perform(curl);
-    output += out.str();
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(request_headers);
+
+    if (_cache) {
+        long status = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+        if (!_cache->finishResponse(url, cached ? &entry : nullptr, res == CURLE_OK, status, body,
+                                    response_headers.etag, response_headers.last_modified)) {
+            return false;
+        }
+        if (output.empty()) {
+            output.swap(body);
+        } else {
+            output += body;
+        }
+        return true;
+    }
     if (res != CURLE_OK) {
         return false;
     } else {
@@ -0,0 +1,118 @@
+#include <bayesian_webclass/id_url_map.h>
+#include <algorithm>
+#include <numeric>
+
+
+/**Constructor
+ */
+IdUrlMap::IdUrlMap() : _offsets(1, 0), _sorted(true) {}
+
+/**Add the entry at the end
+ * The map has to be sorted before it is searched or iterated.
+ * @param id id of the url
+ * @param url url, copied into the arena
+ */
+void IdUrlMap::add(int id, view url) {
+    _sorted = _sorted && (_ids.empty() || _ids.back() < id);
+    _ids.push_back(id);
+    _arena.append(url.data(), url.size());
+    _offsets.push_back(_arena.size());
+}
+
+/**Order the entries by id and drop repeated ids
+ * Of the entries with the same id, the one added first stays.
+ * If the ids were added in increasing order, only the spare capacity is released.
+ */
+void IdUrlMap::sort() {
+    if (_sorted) {
+        _ids.shrink_to_fit();
+        _offsets.shrink_to_fit();
+        _arena.shrink_to_fit();
+        return;
+    }
+    std::vector<std::size_t> order(_ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return _ids[a] < _ids[b];
+    });
+
+    std::vector<int> ids;
+    std::vector<std::size_t> offsets(1, 0);
+    std::string arena;
+    ids.reserve(_ids.size());
+    offsets.reserve(_offsets.size());
+    arena.reserve(_arena.size());
+    for (std::size_t i : order) {
+        if (!ids.empty() && ids.back() == _ids[i]) {
+            continue;
+        }
+        ids.push_back(_ids[i]);
+        arena.append(_arena, _offsets[i], _offsets[i + 1] - _offsets[i]);
+        offsets.push_back(arena.size());
+    }
+    ids.shrink_to_fit();
+    offsets.shrink_to_fit();
+    _ids.swap(ids);
+    _offsets.swap(offsets);
+    _arena.swap(arena);
+    _sorted = true;
+}
+
+/**Remove all entries
+ */
+void IdUrlMap::clear() {
+    _ids.clear();
+    _offsets.assign(1, 0);
+    _arena.clear();
+    _sorted = true;
+}
+
+/**Number of entries
+ */
+std::size_t IdUrlMap::size() const {
+    return _ids.size();
+}
+
+/**Check if there are no entries
+ */
+bool IdUrlMap::empty() const {
+    return _ids.empty();
+}
+
+/**Get the entry
+ * @param index position of the entry in the order of ids
+ * @return id and view of its url, valid until the map is changed
+ */
+IdUrlMap::value_type IdUrlMap::at(std::size_t index) const {
+    return value_type(_ids[index], view(_arena.data() + _offsets[index], _offsets[index + 1] - _offsets[index]));
+}
+
+/**Iterator to the entry with the smallest id
+ */
+IdUrlMap::const_iterator IdUrlMap::begin() const {
+    return const_iterator(this, 0);
+}
+
+/**Iterator past the last entry
+ */
+IdUrlMap::const_iterator IdUrlMap::end() const {
+    return const_iterator(this, _ids.size());
+}
+
+/**Find the entry by binary search
+ * @param id id of the url
+ * @return iterator to the entry, end() if there is none
+ */
+IdUrlMap::const_iterator IdUrlMap::find(int id) const {
+    std::vector<int>::const_iterator it = std::lower_bound(_ids.begin(), _ids.end(), id);
+    if (it == _ids.end() || *it != id) {
+        return end();
+    }
+    return const_iterator(this, it - _ids.begin());
+}
+
+/**Number of entries with the id, 0 or 1
+ */
+std::size_t IdUrlMap::count(int id) const {
+    return find(id) == end() ? 0 : 1;
+}
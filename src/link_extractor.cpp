@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <libxml/HTMLparser.h>
+#include "bayesian_webclass/link_extractor.h"
+
+/**Constructor
+ * @param steps parsed path, see parsePath
+ * @param links found links are inserted here
+ */
+LinkPathTracker::LinkPathTracker(const std::vector<Step> &steps, std::set<std::string> &links)
+        : _steps(steps), _links(links), _depth(0), _matched(0) {}
+
+/**Element opened
+ * @param name element name
+ * @param id value of the id attribute, nullptr if there is none
+ * @param href value of the href attribute, nullptr if there is none
+ */
+void LinkPathTracker::startElement(const char *name, const char *id, const char *href) {
+    if (_matched == _depth && _matched < _steps.size()) {
+        const Step &step = _steps[_matched];
+        if ((step.name == "*" || step.name == name) && (!step.has_id || (id && step.id == id))) {
+            ++_matched;
+        }
+    }
+    ++_depth;
+
+    std::string attribute;
+    if (_matched == _steps.size() && href && std::strcmp(name, "a") == 0 && toAttribute(href, attribute)) {
+        _links.insert(attribute);
+    }
+}
+
+/**Element closed
+ */
+void LinkPathTracker::endElement() {
+    if (_depth == 0) {
+        return;
+    }
+    if (_matched == _depth) {
+        --_matched;
+    }
+    --_depth;
+}
+
+/**Parse the path
+ * @param[in] path absolute path, e.g. "/html/body/div[@id='content']/p"
+ * @param[out] steps steps of the path
+ * @return false if the path is not supported
+ */
+bool LinkPathTracker::parsePath(const std::string &path, std::vector<Step> &steps) {
+    steps.clear();
+    std::string::size_type pos = 0;
+    while (pos < path.size()) {
+        if (path[pos] != '/' || pos + 1 == path.size() || path[pos + 1] == '/') {
+            return false; //relative path, "//" or trailing '/'
+        }
+        std::string::size_type end = pos + 1;
+        while (end < path.size() && path[end] != '/' && path[end] != '[') {
+            ++end;
+        }
+        Step step;
+        step.name = path.substr(pos + 1, end - pos - 1);
+        step.has_id = false;
+        if (end < path.size() && path[end] == '[') {
+            std::string::size_type close = path.find(']', end);
+            if (close == std::string::npos || close < end + 7 || path.compare(end, 5, "[@id=") != 0) {
+                return false;
+            }
+            char quote = path[end + 5];
+            if ((quote != '\'' && quote != '"') || path[close - 1] != quote) {
+                return false;
+            }
+            step.id = path.substr(end + 6, close - end - 7);
+            step.has_id = true;
+            end = close + 1;
+        }
+        if (step.name.empty() || (end < path.size() && path[end] != '/')) {
+            return false;
+        }
+        steps.push_back(step);
+        pos = end;
+    }
+    return !steps.empty();
+}
+
+/**Make the attribute from the link
+ * Only links to articles are used, that is "/wiki/..." without ':'.
+ * @param[in] href link
+ * @param[out] attribute link without "/wiki/"
+ * @return false if the link is not an attribute
+ */
+bool LinkPathTracker::toAttribute(const char *href, std::string &attribute) {
+    if (std::strncmp(href, "/wiki/", 6) != 0 || std::strchr(href, ':')) {
+        return false;
+    }
+    attribute.assign(href + 6);
+    return true;
+}
+
+/** SAX callbacks, ctx is the LinkPathTracker */
+static void onStartElement(void *ctx, const xmlChar *name, const xmlChar **atts) {
+    const char *id = nullptr, *href = nullptr;
+    for (const xmlChar **a = atts; a && a[0]; a += 2) {
+        if (!id && xmlStrcmp(a[0], BAD_CAST "id") == 0) {
+            id = reinterpret_cast<const char *>(a[1] ? a[1] : BAD_CAST "");
+        } else if (!href && xmlStrcmp(a[0], BAD_CAST "href") == 0) {
+            href = reinterpret_cast<const char *>(a[1]);
+        }
+    }
+    static_cast<LinkPathTracker *>(ctx)->startElement(reinterpret_cast<const char *>(name), id, href);
+}
+
+static void onEndElement(void *ctx, const xmlChar *) {
+    static_cast<LinkPathTracker *>(ctx)->endElement();
+}
+
+/**Constructor
+ */
+SaxEventSource::SaxEventSource() {
+    xmlInitParser();
+}
+
+/**Parse with the libxml2 HTML push parser
+ * @param html html code
+ * @param tracker receives the element events
+ * @return false only if the parser cannot be created
+ */
+bool SaxEventSource::parse(const std::string &html, LinkPathTracker &tracker) const {
+    static const std::size_t CHUNK = 64 * 1024;
+    htmlSAXHandler sax;
+    std::memset(&sax, 0, sizeof(sax));
+    sax.startElement = onStartElement;
+    sax.endElement = onEndElement;
+
+    htmlParserCtxtPtr ctxt = htmlCreatePushParserCtxt(&sax, &tracker, nullptr, 0, nullptr, XML_CHAR_ENCODING_UTF8);
+    if (!ctxt) {
+        return false;
+    }
+    htmlCtxtUseOptions(ctxt, HTML_PARSE_RECOVER | HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+    for (std::size_t pos = 0; pos < html.size(); pos += CHUNK) {
+        htmlParseChunk(ctxt, html.data() + pos, static_cast<int>(std::min(CHUNK, html.size() - pos)), 0);
+    }
+    htmlParseChunk(ctxt, nullptr, 0, 1);
+    htmlFreeParserCtxt(ctxt);
+    return true;
+}
+
+/** elements without content, they have no end tag */
+static bool isVoidElement(const std::string &name) {
+    static const std::set<std::string> names = {"area", "base", "br", "col", "embed", "hr", "img", "input",
+                                                 "link", "meta", "param", "source", "track", "wbr"};
+    return names.count(name) > 0;
+}
+
+/** elements which close an open <p> */
+static bool closesParagraph(const std::string &name) {
+    static const std::set<std::string> names = {"address", "article", "aside", "blockquote", "div", "dl",
+                                                "fieldset", "figure", "footer", "form", "h1", "h2", "h3", "h4",
+                                                "h5", "h6", "header", "hr", "main", "nav", "ol", "p", "pre",
+                                                "section", "table", "ul"};
+    return names.count(name) > 0;
+}
+
+/** elements whose content is not html */
+static bool isRawText(const std::string &name) {
+    return name == "script" || name == "style" || name == "textarea" || name == "title";
+}
+
+/** characters allowed in tag and attribute names */
+static bool isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == ':' || c == '.';
+}
+
+/** decode the character references used in links */
+static void decodeEntities(std::string &value) {
+    static const char *const entities[][2] = {{"&amp;", "&"}, {"&quot;", "\""}, {"&#39;", "'"},
+                                              {"&lt;", "<"}, {"&gt;", ">"}};
+    std::string::size_type pos = 0;
+    while ((pos = value.find('&', pos)) != std::string::npos) {
+        for (const auto &e : entities) {
+            std::size_t len = std::strlen(e[0]);
+            if (value.compare(pos, len, e[0]) == 0) {
+                value.replace(pos, len, e[1]);
+                break;
+            }
+        }
+        ++pos;
+    }
+}
+
+/**Tokenize the html
+ * @param html html code
+ * @param tracker receives the element events
+ * @return false if the page cannot be followed, use another source then
+ */
+bool TokenizerEventSource::parse(const std::string &html, LinkPathTracker &tracker) const {
+    static const std::size_t MAX_DEPTH = 512;
+    std::vector<std::string> open;  //names of open elements
+    std::string name, attr, value, id, href;
+    const char *p = html.data();
+    const char *const end = p + html.size();
+
+    while ((p = static_cast<const char *>(std::memchr(p, '<', end - p)))) {
+        ++p;
+        if (p == end) {
+            return false;
+        }
+        if (end - p >= 3 && std::strncmp(p, "!--", 3) == 0) { //comment
+            const char *close = std::search(p + 3, end, "-->", "-->" + 3);
+            if (close == end) {
+                return false;
+            }
+            p = close + 3;
+            continue;
+        }
+        if (*p == '!' || *p == '?') { //doctype, processing instruction
+            p = std::find(p, end, '>');
+            if (p == end) {
+                return false;
+            }
+            continue;
+        }
+        bool closing = (*p == '/');
+        if (closing) {
+            ++p;
+        }
+        if (p == end || !std::isalpha(static_cast<unsigned char>(*p))) {
+            continue; //'<' in text
+        }
+
+        name.clear();
+        for (; p != end && isNameChar(*p); ++p) {
+            name += static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+        }
+
+        bool self_closing = false, has_id = false, has_href = false;
+        while (true) { //attributes
+            while (p != end && std::isspace(static_cast<unsigned char>(*p))) {
+                ++p;
+            }
+            if (p == end) {
+                return false;
+            }
+            if (*p == '>') {
+                ++p;
+                break;
+            }
+            if (*p == '/') {
+                self_closing = true;
+                ++p;
+                continue;
+            }
+            attr.clear();
+            for (; p != end && !std::isspace(static_cast<unsigned char>(*p)) && *p != '=' && *p != '>' && *p != '/'; ++p) {
+                attr += static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+            }
+            while (p != end && std::isspace(static_cast<unsigned char>(*p))) {
+                ++p;
+            }
+            value.clear();
+            if (p != end && *p == '=') {
+                ++p;
+                while (p != end && std::isspace(static_cast<unsigned char>(*p))) {
+                    ++p;
+                }
+                if (p != end && (*p == '"' || *p == '\'')) {
+                    const char *close = std::find(p + 1, end, *p);
+                    if (close == end) {
+                        return false;
+                    }
+                    value.assign(p + 1, close);
+                    p = close + 1;
+                } else {
+                    const char *begin = p;
+                    while (p != end && !std::isspace(static_cast<unsigned char>(*p)) && *p != '>') {
+                        ++p;
+                    }
+                    value.assign(begin, p);
+                }
+            }
+            if (closing) {
+                continue;
+            }
+            if (attr == "id" && !has_id) {
+                id.swap(value);
+                decodeEntities(id);
+                has_id = true;
+            } else if (attr == "href" && !has_href) {
+                href.swap(value);
+                decodeEntities(href);
+                has_href = true;
+            }
+        }
+
+        if (closing) {
+            std::vector<std::string>::size_type i = open.size();
+            while (i > 0 && open[i - 1] != name) {
+                --i;
+            }
+            for (; i > 0 && open.size() >= i; open.pop_back()) { //close up to the matching element
+                tracker.endElement();
+            }
+            continue;
+        }
+
+        if (closesParagraph(name) || name == "li") {
+            const std::string &closed = (name == "li") ? name : std::string("p");
+            std::vector<std::string>::size_type i = open.size();
+            while (i > 0 && open[i - 1] != closed && open[i - 1] != "table" && open[i - 1] != "div"
+                   && open[i - 1] != "ul" && open[i - 1] != "ol") {
+                --i;
+            }
+            for (; i > 0 && open.size() >= i && open[i - 1] == closed; open.pop_back()) {
+                tracker.endElement();
+            }
+        }
+
+        tracker.startElement(name.c_str(), has_id ? id.c_str() : nullptr, has_href ? href.c_str() : nullptr);
+        open.push_back(name);
+        if (self_closing || isVoidElement(name)) {
+            tracker.endElement();
+            open.pop_back();
+        } else if (isRawText(name)) {
+            std::string end_tag = "</" + name;
+            const char *close = std::search(p, end, end_tag.begin(), end_tag.end(),
+                                            [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+            p = close; //the end tag is read in the next step
+        }
+        if (open.size() > MAX_DEPTH) {
+            return false;
+        }
+    }
+    for (; !open.empty(); open.pop_back()) {
+        tracker.endElement();
+    }
+    return true; //a page without the path has no links, other parsers would not find them either
+}
+
+/**Constructor
+ * @param path path of the elements from which links are taken, see LinkPathTracker
+ */
+LinkExtractor::LinkExtractor(const std::string &path) : _valid(LinkPathTracker::parsePath(path, _steps)) {}
+
+/**Check if the path is supported
+ * @return false if the path cannot be tracked, use HTTPDownloader::parseHtmlAndSave then
+ */
+bool LinkExtractor::isValid() const {
+    return _valid;
+}
+
+/**Extract links with the libxml2 HTML push parser
+ * @param[in] html html code
+ * @param[out] links found links are inserted here
+ * @return number of links in links
+ */
+int LinkExtractor::extract(const std::string &html, std::set<std::string> &links) const {
+    static const SaxEventSource sax;
+    extract(html, links, sax);
+    return links.size();
+}
+
+/**Extract links with the given parser
+ * @param[in] html html code
+ * @param[out] links found links are inserted here, only if the source succeeded
+ * @param[in] source parser sending the element events
+ * @return false if the path is not supported or the source failed
+ */
+bool LinkExtractor::extract(const std::string &html, std::set<std::string> &links,
+                            const HtmlEventSource &source) const {
+    if (!_valid) {
+        return false;
+    }
+    std::set<std::string> found;
+    LinkPathTracker tracker(_steps, found);
+    if (!source.parse(html, tracker)) {
+        return false;
+    }
+    links.insert(found.begin(), found.end());
+    return true;
+}
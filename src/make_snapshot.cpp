@@ -0,0 +1,27 @@
+#include <bayesian_webclass/classifier.h>
+#include <iostream>
+#include <string>
+int main(int argc, char* argv[]) {  //trains the classifier and saves it as a snapshot for ClassifierService::load
+
+    if (argc == 5) {    //train on the counters merged by merge_counts
+        Classifier c;
+        c.loadAttributes(argv[1]);
+        c.loadCategories(argv[2]);
+        CountTable counts;
+        if (!counts.load(argv[3]) || !c.trainFromCounts(counts) || !c.saveSnapshot(argv[4])) {
+            return 1;
+        }
+        return 0;
+    }
+    if (argc < 6) {
+        std::cerr << "Usage: " << argv[0] << " attributes categories examples_dir examples_num snapshot" << std::endl;
+        std::cerr << "       " << argv[0] << " attributes categories counts snapshot" << std::endl;
+        return 1;
+    }
+
+    Classifier c;
+    if (!c.init(argv[1], argv[2], argv[3], std::stoi(argv[4])) || !c.saveSnapshot(argv[5])) {
+        return 1;
+    }
+    return 0;
+}
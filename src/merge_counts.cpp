@@ -0,0 +1,28 @@
+#include <bayesian_webclass/count_table.h>
+#include <iostream>
+int main(int argc, char* argv[]) {  //sums the counters saved by count_examples on many workers
+
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " merged_counts counts..." << std::endl;
+        return 1;
+    }
+
+    CountTable merged;
+    for (int i = 2; i < argc; ++i) {
+        CountTable shard;
+        if (!shard.load(argv[i])) {
+            return 1;
+        }
+        if (i == 2) {
+            merged = shard;
+        }
+        else if (!merged.merge(shard)) {
+            std::cerr << "Cannot merge: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (!merged.save(argv[1])) {
+        return 1;
+    }
+    return 0;
+}
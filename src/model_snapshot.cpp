@@ -0,0 +1,317 @@
+#include "bayesian_webclass/model_snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/** \struct ModelSnapshot::Header
+ *  \brief Fixed size header at the beginning of the snapshot file.
+ *  Sections are given as byte offsets from the beginning of the file.
+ */
+
+struct ModelSnapshot::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t attribute_count;
+    std::uint32_t category_count;
+    std::uint32_t reserved;
+    std::uint64_t attribute_names;      // uint32_t[attribute_count + 1], offsets into strings
+    std::uint64_t category_names;       // uint32_t[category_count + 1], offsets into strings
+    std::uint64_t attribute_order;      // uint32_t[attribute_count], attribute ids sorted by name
+    std::uint64_t strings;              // char[], names without separators
+    std::uint64_t baseline;             // double[category_count]
+    std::uint64_t delta;                // double[attribute_count][category_count]
+    std::uint64_t file_size;
+};
+
+static const char MAGIC[8] = {'B', 'W', 'C', 'M', 'O', 'D', 'E', 'L'};
+
+/** \brief Round the offset up to the multiple of 8 bytes. */
+
+static std::uint64_t align8(std::uint64_t offset) {
+    return (offset + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+/** \brief Check that the name offsets do not decrease and stay
+ * in the string arena, so every name is a valid range. */
+
+static bool validOffsets(const std::uint32_t* offsets, std::uint64_t count,
+                         std::uint64_t strings_size) {
+    for(std::uint64_t i = 0; i < count; ++i) {
+        if(offsets[i] > offsets[i + 1])
+            return false;
+    }
+    return offsets[count] <= strings_size;
+}
+
+/** \brief Write zero bytes until the stream reaches the given offset. */
+
+static void padTo(std::ofstream& output, std::uint64_t offset) {
+    static const char zeros[8] = {0};
+    std::uint64_t pos = static_cast<std::uint64_t>(output.tellp());
+    if(pos < offset)
+        output.write(zeros, offset - pos);
+}
+
+/** \brief Constructor.
+ * Creates a closed snapshot, use open to map a file.
+ */
+
+ModelSnapshot::ModelSnapshot() : _data(nullptr), _size(0), _header(nullptr),
+                                 _attrib_names(nullptr), _cat_names(nullptr), _attrib_order(nullptr),
+                                 _strings(nullptr) {}
+
+/** \brief Destructor, unmaps the file.
+ */
+
+ModelSnapshot::~ModelSnapshot() {
+    close();
+}
+
+/** \brief Write the snapshot file.
+ * @param filename name of the file to write
+ * @param attributes attribute names, position is the attribute id
+ * @param categories category names, position is the category id
+ * @param model log-probability tables, built for the given attributes
+ *        and categories
+ * @return false if the tables do not match or the file cannot be written
+ */
+
+bool ModelSnapshot::write(const std::string& filename,
+                          const std::vector<std::string>& attributes,
+                          const std::vector<std::string>& categories,
+                          const BernoulliModel& model) {
+    const std::size_t A = attributes.size();
+    const std::size_t C = categories.size();
+    if(A == 0 || C == 0 || model.getAttributeCount() != A || model.getCategoryCount() != C) {
+        std::cerr << "Snapshot tables do not match attributes and categories" << std::endl;
+        return false;
+    }
+
+    std::string strings;
+    std::vector<std::uint32_t> attrib_names, cat_names;
+    for(const std::string& w : attributes) {
+        attrib_names.push_back(static_cast<std::uint32_t>(strings.size()));
+        strings += w;
+    }
+    attrib_names.push_back(static_cast<std::uint32_t>(strings.size()));
+    for(const std::string& w : categories) {
+        cat_names.push_back(static_cast<std::uint32_t>(strings.size()));
+        strings += w;
+    }
+    cat_names.push_back(static_cast<std::uint32_t>(strings.size()));
+    if(strings.size() > std::numeric_limits<std::uint32_t>::max()) {
+        std::cerr << "Too many attribute names for snapshot" << std::endl;
+        return false;
+    }
+
+    std::vector<std::uint32_t> attrib_order(A);
+    for(std::size_t i = 0; i < A; ++i)
+        attrib_order[i] = static_cast<std::uint32_t>(i);
+    std::sort(attrib_order.begin(), attrib_order.end(),
+              [&attributes](std::uint32_t a, std::uint32_t b) { return attributes[a] < attributes[b]; });
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.attribute_count = static_cast<std::uint32_t>(A);
+    h.category_count = static_cast<std::uint32_t>(C);
+    h.attribute_names = sizeof(Header);
+    h.category_names = h.attribute_names + attrib_names.size() * sizeof(std::uint32_t);
+    h.attribute_order = h.category_names + cat_names.size() * sizeof(std::uint32_t);
+    h.strings = h.attribute_order + attrib_order.size() * sizeof(std::uint32_t);
+    h.baseline = align8(h.strings + strings.size());
+    h.delta = h.baseline + C * sizeof(double);
+    h.file_size = h.delta + A * C * sizeof(double);
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if(!output.is_open()) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    output.write(reinterpret_cast<const char*>(attrib_names.data()), attrib_names.size() * sizeof(std::uint32_t));
+    output.write(reinterpret_cast<const char*>(cat_names.data()), cat_names.size() * sizeof(std::uint32_t));
+    output.write(reinterpret_cast<const char*>(attrib_order.data()), attrib_order.size() * sizeof(std::uint32_t));
+    output.write(strings.data(), strings.size());
+    padTo(output, h.baseline);
+    output.write(reinterpret_cast<const char*>(model.getBaseline()), C * sizeof(double));
+    output.write(reinterpret_cast<const char*>(model.getDelta()), A * C * sizeof(double));
+    return output.good();
+}
+
+/** \brief Map the snapshot file into memory.
+ * Only the header is checked, the tables are read on demand
+ * by the classification.
+ * @param filename name of the snapshot file
+ * @return false if the file cannot be mapped or is not a valid snapshot
+ */
+
+bool ModelSnapshot::open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        std::cerr << "Invalid snapshot file: " << filename << std::endl;
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);    // the mapping stays valid after closing the descriptor
+    if(data == MAP_FAILED) {
+        std::cerr << "Cannot map file: " << filename << std::endl;
+        return false;
+    }
+    _data = static_cast<const char*>(data);
+    _size = st.st_size;
+    _header = reinterpret_cast<const Header*>(_data);
+
+    const Header& h = *_header;
+    const std::uint64_t A = h.attribute_count;
+    const std::uint64_t C = h.category_count;
+    bool valid = std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+                 && h.version == VERSION
+                 && h.file_size == _size
+                 && C > 0
+                 && h.attribute_names + (A + 1) * sizeof(std::uint32_t) <= h.category_names
+                 && h.category_names + (C + 1) * sizeof(std::uint32_t) <= h.attribute_order
+                 && h.attribute_order + A * sizeof(std::uint32_t) <= h.strings
+                 && h.strings <= h.baseline
+                 && h.baseline % sizeof(double) == 0
+                 && h.baseline + C * sizeof(double) <= h.delta
+                 && h.delta + A * C * sizeof(double) <= _size;
+    if(valid) {
+        _attrib_names = reinterpret_cast<const std::uint32_t*>(_data + h.attribute_names);
+        _cat_names = reinterpret_cast<const std::uint32_t*>(_data + h.category_names);
+        _attrib_order = reinterpret_cast<const std::uint32_t*>(_data + h.attribute_order);
+        _strings = _data + h.strings;
+        const std::uint64_t strings_size = h.baseline - h.strings;
+        valid = validOffsets(_attrib_names, A, strings_size)
+                && validOffsets(_cat_names, C, strings_size);
+        for(std::uint64_t i = 0; valid && i < A; ++i)
+            valid = _attrib_order[i] < A;
+    }
+    if(valid) {
+        _model.attach(A, C, reinterpret_cast<const double*>(_data + h.baseline),
+                      reinterpret_cast<const double*>(_data + h.delta));
+    }
+    if(!valid) {
+        close();
+        std::cerr << "Invalid snapshot file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** \brief Unmap the snapshot file.
+ */
+
+void ModelSnapshot::close() {
+    if(_data)
+        munmap(const_cast<char*>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+    _header = nullptr;
+    _attrib_names = _cat_names = _attrib_order = nullptr;
+    _strings = nullptr;
+    _model.attach(0, 0, nullptr, nullptr);
+}
+
+/** \brief Check if a snapshot file is mapped.
+ */
+
+bool ModelSnapshot::isOpen() const {
+    return _data != nullptr;
+}
+
+/** \brief Number of attributes in the snapshot.
+ */
+
+std::size_t ModelSnapshot::getAttributeCount() const {
+    return _header ? _header->attribute_count : 0;
+}
+
+/** \brief Number of categories in the snapshot.
+ */
+
+std::size_t ModelSnapshot::getCategoryCount() const {
+    return _header ? _header->category_count : 0;
+}
+
+/** \brief Name of the category with the given id.
+ */
+
+std::string ModelSnapshot::getCategory(std::size_t index) const {
+    return getName(_cat_names, index);
+}
+
+/** \brief Name stored in the string arena.
+ * @param offsets offsets table (attribute or category names)
+ * @param index position in the table
+ */
+
+std::string ModelSnapshot::getName(const std::uint32_t* offsets, std::size_t index) const {
+    return std::string(_strings + offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+/** \brief Find the attribute id.
+ * Binary search over the attribute ids sorted by name.
+ * @param word attribute name
+ * @return attribute id or -1 if the word is not an attribute
+ */
+
+int ModelSnapshot::findAttribute(const std::string& word) const {
+    if(!_header)
+        return -1;
+    const std::uint32_t* begin = _attrib_order;
+    const std::uint32_t* end = _attrib_order + _header->attribute_count;
+    const std::uint32_t* it = std::lower_bound(begin, end, word,
+        [this](std::uint32_t id, const std::string& w) {
+            std::size_t len = _attrib_names[id + 1] - _attrib_names[id];
+            int cmp = std::memcmp(_strings + _attrib_names[id], w.data(), std::min(len, w.size()));
+            return cmp < 0 || (cmp == 0 && len < w.size());
+        });
+    if(it == end || word.compare(0, std::string::npos, _strings + _attrib_names[*it],
+                                 _attrib_names[*it + 1] - _attrib_names[*it]) != 0)
+        return -1;
+    return static_cast<int>(*it);
+}
+
+/** \brief Log-probability tables of the snapshot.
+ */
+
+const BernoulliModel& ModelSnapshot::getModel() const {
+    return _model;
+}
+
+/** \brief Classify an example given by its attributes.
+ * Same result as Classifier::classify on the classifier the snapshot
+ * was written from.
+ * @param attribs set of attributes (links) found in the example
+ * @return name of the most probable category
+ */
+
+std::string ModelSnapshot::classify(const std::set<std::string>& attribs) const {
+    if(!_header)
+        return "";
+
+    SparseExample example;
+    for(const std::string& word : attribs) {
+        int id = findAttribute(word);
+        if(id >= 0)
+            example.push_back(id);
+    }
+    std::sort(example.begin(), example.end());
+    return getCategory(_model.classify(example));
+}
@@ -0,0 +1,105 @@
+#include "bayesian_webclass/multinomial_model.h"
+#include <algorithm>
+#include <cmath>
+
+
+/** \brief Constructor.
+ * Creates an empty model, use train to set the weights.
+ */
+
+MultinomialModel::MultinomialModel() : _terms(0), _categories(0), _variant(MULTINOMIAL) {}
+
+/** \brief Train the model on labelled documents.
+ * The term mass N(c, t) is the sum of the term weights in the
+ * documents of category c, N(c) the sum over all terms.
+ * Multinomial weight: log((N(c, t) + alpha) / (N(c) + alpha * terms)),
+ * complement weight: -log((N(~c, t) + alpha) / (N(~c) + alpha * terms)),
+ * where ~c are all categories but c. The log-prior of a category is
+ * log((documents of c + 1) / (documents + categories)), as in
+ * faif::ml::NaiveBayesian.
+ * @param terms number of terms, ids in documents are lower
+ * @param categories number of categories
+ * @param documents training documents (counts or TF-IDF weights)
+ * @param labels category of each document, lower than categories
+ * @param variant multinomial or complement weights
+ * @param alpha additive (Laplace) smoothing
+ */
+
+void MultinomialModel::train(std::size_t terms, std::size_t categories,
+                             const std::vector<TermVector>& documents,
+                             const std::vector<int>& labels,
+                             Variant variant, double alpha) {
+    _terms = terms;
+    _categories = categories;
+    _variant = variant;
+
+    std::vector<double> mass(terms * categories, 0.0);   // [term][category]
+    std::vector<double> total(categories, 0.0);
+    std::vector<int> docs(categories, 0);
+    for(std::size_t d = 0; d < documents.size(); ++d) {
+        const int c = labels[d];
+        ++docs[c];
+        for(const std::pair<int, float>& t : documents[d]) {
+            mass[t.first * categories + c] += t.second;
+            total[c] += t.second;
+        }
+    }
+
+    _bias.resize(categories);
+    for(std::size_t c = 0; c < categories; ++c) {
+        _bias[c] = static_cast<float>(std::log((docs[c] + 1.0) / (documents.size() + categories)));
+    }
+
+    double all = 0.0;
+    for(double n : total)
+        all += n;
+    std::vector<double> denominator(categories);
+    for(std::size_t c = 0; c < categories; ++c) {
+        double n = variant == COMPLEMENT ? all - total[c] : total[c];
+        denominator[c] = std::log(n + alpha * terms);
+    }
+
+    _weights.resize(terms * categories);
+    for(std::size_t t = 0; t < terms; ++t) {
+        const double* row = &mass[t * categories];
+        double term_all = 0.0;
+        for(std::size_t c = 0; c < categories; ++c)
+            term_all += row[c];
+        for(std::size_t c = 0; c < categories; ++c) {
+            double w = variant == COMPLEMENT
+                       ? denominator[c] - std::log(term_all - row[c] + alpha)
+                       : std::log(row[c] + alpha) - denominator[c];
+            _weights[t * categories + c] = static_cast<float>(w);
+        }
+    }
+}
+
+/** \brief Score of every category for the document.
+ * @param[in] document term vector, terms not lower than getTermCount() are skipped
+ * @param[out] scores getCategoryCount() scores
+ */
+
+void MultinomialModel::score(const TermVector& document, double* scores) const {
+    std::copy(_bias.begin(), _bias.end(), scores);
+    for(const std::pair<int, float>& t : document) {
+        if(t.first < 0 || static_cast<std::size_t>(t.first) >= _terms)
+            continue;
+        const float* row = &_weights[t.first * _categories];
+        const double x = t.second;
+        for(std::size_t c = 0; c < _categories; ++c)
+            scores[c] += x * row[c];
+    }
+}
+
+/** \brief Classify the document.
+ * @param document term vector
+ * @return id of the category with the highest score, -1 if there are no categories
+ */
+
+int MultinomialModel::classify(const TermVector& document) const {
+    std::vector<double> scores(_categories);
+    if(scores.empty())
+        return -1;
+    score(document, &scores[0]);
+    return static_cast<int>(std::max_element(scores.begin(), scores.end()) - scores.begin());
+}
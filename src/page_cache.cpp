@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+#include <zlib.h>
+#include <boost/filesystem/operations.hpp>
+#include "bayesian_webclass/page_cache.h"
+#include "bayesian_webclass/fnv_hash.h"
+
+static const char MAGIC[] = "BWCPAGE 1";
+
+/**Constructor
+ * @param directory directory with cached pages, created if it does not exist
+ * @param max_age time in seconds after which a page is revalidated, negative - never
+ */
+PageCache::PageCache(const std::string &directory, long max_age) : _directory(directory), _max_age(max_age) {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(_directory, ec);
+}
+
+/**Find the cached page
+ * @param[in] url url of the page, normalised here
+ * @param[out] entry cached page
+ * @return false if the page is not in the cache or its file is damaged
+ */
+bool PageCache::lookup(const std::string &url, Entry &entry) const {
+    const std::string normalised = normaliseUrl(url);
+    std::ifstream input(getFilename(normalised), std::ios::binary);
+    std::string line;
+    if (!std::getline(input, line) || line != MAGIC) {
+        return false;
+    }
+    std::size_t size = 0;
+    entry = Entry();
+    entry.time = 0;
+    while (std::getline(input, line) && !line.empty()) {
+        std::string::size_type space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = (space == std::string::npos) ? std::string() : line.substr(space + 1);
+        if (key == "url") {
+            entry.url = value;
+        } else if (key == "etag") {
+            entry.etag = value;
+        } else if (key == "last-modified") {
+            entry.last_modified = value;
+        } else if (key == "time") {
+            entry.time = static_cast<std::time_t>(std::strtoll(value.c_str(), nullptr, 10));
+        } else if (key == "size") {
+            size = static_cast<std::size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        }
+    }
+    if (!input || entry.url != normalised) { //other url with the same hash
+        return false;
+    }
+    std::string compressed((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    entry.body.resize(size);
+    uLongf body_size = size;
+    if (size > 0 && (uncompress(reinterpret_cast<Bytef *>(&entry.body[0]), &body_size,
+                                reinterpret_cast<const Bytef *>(compressed.data()), compressed.size()) != Z_OK
+                     || body_size != size)) {
+        return false;
+    }
+    return true;
+}
+
+/**Check if the page can be used without asking the server
+ * @param entry cached page
+ * @return true if the page is younger than max_age
+ */
+bool PageCache::isFresh(const Entry &entry) const {
+    return _max_age < 0 || std::difftime(std::time(nullptr), entry.time) < _max_age;
+}
+
+/**Save the page in the cache
+ * Also used to mark a revalidated page as fresh.
+ * @param url url of the page, normalised here
+ * @param body body of the page
+ * @param size size of the body
+ * @param etag ETag header of the response, may be empty
+ * @param last_modified Last-Modified header of the response, may be empty
+ * @return false if the page cannot be written
+ */
+bool PageCache::store(const std::string &url, const char *body, std::size_t size,
+                      const std::string &etag, const std::string &last_modified) const {
+    static std::atomic<unsigned> counter(0);
+    const std::string normalised = normaliseUrl(url);
+    const std::string filename = getFilename(normalised);
+
+    uLongf compressed_size = compressBound(size);
+    std::string compressed(compressed_size, '\0');
+    if (compress2(reinterpret_cast<Bytef *>(&compressed[0]), &compressed_size,
+                  reinterpret_cast<const Bytef *>(body), size, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return false;
+    }
+
+    std::string tmp = filename + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++);
+    {
+        std::ofstream output(tmp, std::ios::binary | std::ios::trunc);
+        output << MAGIC << "\n"
+               << "url " << normalised << "\n"
+               << "etag " << etag << "\n"
+               << "last-modified " << last_modified << "\n"
+               << "time " << static_cast<long long>(std::time(nullptr)) << "\n"
+               << "size " << size << "\n\n";
+        output.write(compressed.data(), compressed_size);
+        if (!output.good()) {
+            output.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+/**Save the response and choose the body to use
+ * A new page (status 200) is stored, a page not modified since the cached
+ * copy (status 304) is marked fresh again and the cached body is used.
+ * If the download failed or the server answered with any other status, the
+ * stale cached copy is used. Without a cached copy only status 200 succeeds.
+ * @param[in] url url of the page
+ * @param[in] cached cached page sent in the conditional request, nullptr if none
+ * @param[in] success true if the transfer succeeded
+ * @param[in] status HTTP status of the response
+ * @param[in,out] body downloaded body, replaced by the cached body if it is used
+ * @param[in] etag ETag header of the response
+ * @param[in] last_modified Last-Modified header of the response
+ * @return true if body holds the page
+ */
+bool PageCache::finishResponse(const std::string &url, const Entry *cached, bool success, long status,
+                               std::string &body, const std::string &etag, const std::string &last_modified) const {
+    if (cached && (!success || status != 200)) {
+        body = cached->body;
+        if (success && status == 304) {
+            store(url, body.data(), body.size(), etag.empty() ? cached->etag : etag,
+                  last_modified.empty() ? cached->last_modified : last_modified);
+        }
+        return true;
+    }
+    if (!success || status != 200) {
+        return false;
+    }
+    store(url, body.data(), body.size(), etag, last_modified);
+    return true;
+}
+
+/**Headers of the conditional request revalidating the page
+ * @param entry cached page
+ * @return If-None-Match and If-Modified-Since headers, the ones known for the page
+ */
+std::vector<std::string> PageCache::conditionalHeaders(const Entry &entry) {
+    std::vector<std::string> headers;
+    if (!entry.etag.empty()) {
+        headers.push_back("If-None-Match: " + entry.etag);
+    }
+    if (!entry.last_modified.empty()) {
+        headers.push_back("If-Modified-Since: " + entry.last_modified);
+    }
+    return headers;
+}
+
+/**Take ETag and Last-Modified from the response header line
+ * A status line starts a new response (after a redirect), the values are cleared then.
+ * @param[in] line header line as given by curl, not null terminated
+ * @param[in] size length of the line
+ * @param[out] etag value of ETag
+ * @param[out] last_modified value of Last-Modified
+ */
+void PageCache::parseHeader(const char *line, std::size_t size, std::string &etag, std::string &last_modified) {
+    std::string header(line, size);
+    if (header.compare(0, 5, "HTTP/") == 0) {
+        etag.clear();
+        last_modified.clear();
+        return;
+    }
+    std::string::size_type colon = header.find(':');
+    if (colon == std::string::npos) {
+        return;
+    }
+    std::string name = header.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    std::string::size_type begin = header.find_first_not_of(" \t", colon + 1);
+    std::string::size_type end = header.find_last_not_of(" \t\r\n");
+    std::string value = (begin == std::string::npos || end < begin) ? std::string()
+                                                                      : header.substr(begin, end - begin + 1);
+    if (name == "etag") {
+        etag = value;
+    } else if (name == "last-modified") {
+        last_modified = value;
+    }
+}
+
+/**Curl header callback (CURLOPT_HEADERFUNCTION) taking the cache headers of the response
+ * @param line header line
+ * @param size size of an item
+ * @param nmemb number of items
+ * @param headers ResponseHeaders filled with the values, set as CURLOPT_HEADERDATA
+ * @return number of bytes taken, always the whole line
+ */
+std::size_t PageCache::headerCallback(char *line, std::size_t size, std::size_t nmemb, void *headers) {
+    ResponseHeaders *response = static_cast<ResponseHeaders *>(headers);
+    parseHeader(line, size * nmemb, response->etag, response->last_modified);
+    return size * nmemb;
+}
+
+/**Normalise the url, so the same page always has the same key
+ * The scheme and host are lowercased, the default port and the fragment
+ * are removed and an empty path becomes "/".
+ * @param url url address
+ * @return normalised url
+ */
+std::string PageCache::normaliseUrl(const std::string &url) {
+    std::string::size_type first = url.find_first_not_of(" \t\r\n");
+    std::string::size_type last = url.find_last_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    std::string u = url.substr(first, last - first + 1);
+    u = u.substr(0, u.find('#'));
+
+    std::string scheme("http");
+    std::string::size_type begin = u.find("://");
+    if (begin != std::string::npos) {
+        scheme = u.substr(0, begin);
+        begin += 3;
+    } else {
+        begin = 0;
+    }
+    std::transform(scheme.begin(), scheme.end(), scheme.begin(), ::tolower);
+
+    std::string::size_type end = u.find_first_of("/?", begin);
+    std::string host = u.substr(begin, end - begin);
+    std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+    std::string default_port = (scheme == "https") ? ":443" : (scheme == "http") ? ":80" : "";
+    if (!default_port.empty() && host.size() > default_port.size()
+        && host.compare(host.size() - default_port.size(), default_port.size(), default_port) == 0) {
+        host.erase(host.size() - default_port.size());
+    }
+
+    std::string path = (end == std::string::npos) ? std::string() : u.substr(end);
+    if (path.empty() || path[0] == '?') {
+        path.insert(0, "/");
+    }
+    return scheme + "://" + host + path;
+}
+
+/**FNV-1a hash
+ * @param str hashed string
+ * @return 64 bit hash
+ */
+std::uint64_t PageCache::hash(const std::string &str) {
+    return fnv1a(str.data(), str.size());
+}
+
+/**Name of the file with the page
+ * @param normalised_url normalised url of the page
+ */
+std::string PageCache::getFilename(const std::string &normalised_url) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.page", static_cast<unsigned long long>(hash(normalised_url)));
+    return _directory + "/" + name;
+}
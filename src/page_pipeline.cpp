@@ -0,0 +1,114 @@
+#include "bayesian_webclass/page_pipeline.h"
+#include "bayesian_webclass/http_downloader.h"
+
+/**Prepare downloaded html code for parsing
+ * Joins lines of html code until every line ends with a closing '>'.
+ * Works in place on the downloaded buffer, no temporary file or copy is used.
+ * @param page page with downloaded html code, prepared for parsing on return
+ * @return always true
+ */
+bool PreparePageStage::process(Page &page) const {
+    std::string &html = page.html;
+    std::string::size_type out = 0, line_start = 0;
+    for (std::string::size_type i = 0; i < html.size(); ++i) {
+        char c = html[i];
+        if (c == '\n' && out > line_start && html[out - 1] != '>') {
+            continue; //join with the next line
+        }
+        html[out++] = c;
+        if (c == '\n') {
+            line_start = out;
+        }
+    }
+    html.resize(out);
+    if (!html.empty() && html.back() != '\n') {
+        html += '\n';
+    }
+    return true;
+}
+
+/**Constructor
+ * @param from_which_tags xpath of the nodes from which links are taken
+ */
+ExtractLinksStage::ExtractLinksStage(const std::string &from_which_tags)
+        : _from_which_tags(from_which_tags), _extractor(from_which_tags) {}
+
+/**Clean the html with libtidy and parse it
+ * @param html html code
+ * @param tracker receives the element events
+ * @return false if tidy failed
+ */
+bool TidyEventSource::parse(const std::string &html, LinkPathTracker &tracker) const {
+    std::string clean;
+    try {
+        clean = HTTPDownloader::cleanhtml(html);
+    }
+    catch (...) {
+        return false;
+    }
+    return SaxEventSource().parse(clean, tracker);
+}
+
+/**Add the html event source
+ * @param source source to add, the stage takes ownership
+ * @return the stage
+ */
+ExtractLinksStage &ExtractLinksStage::addSource(HtmlEventSource *source) {
+    _sources.push_back(std::unique_ptr<HtmlEventSource>(source));
+    return *this;
+}
+
+/**Extract links
+ * @param page page with prepared html code, links are added to page.attribs
+ * @return always true, a page without links is still processed
+ */
+bool ExtractLinksStage::process(Page &page) const {
+    if (_extractor.isValid()) {
+        for (const std::unique_ptr<HtmlEventSource> &source : _sources) {
+            if (_extractor.extract(page.html, page.attribs, *source)) {
+                return true;
+            }
+        }
+        _extractor.extract(page.html, page.attribs);
+        return true;
+    }
+    std::string output_of_parsing;
+    HTTPDownloader::parseHtmlAndSave(page.html, _from_which_tags, output_of_parsing, page.attribs);
+    return true;
+}
+
+/**Add the stage at the end of the pipeline
+ * @param stage stage to add, the pipeline takes ownership
+ * @return the pipeline
+ */
+PagePipeline &PagePipeline::add(PageStage *stage) {
+    _stages.push_back(std::unique_ptr<PageStage>(stage));
+    return *this;
+}
+
+/**Run all stages on the page
+ * @param page page to process
+ * @return false if any stage stopped the page
+ */
+bool PagePipeline::process(Page &page) const {
+    for (const std::unique_ptr<PageStage> &stage : _stages) {
+        if (!stage->process(page)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**Create the pipeline extracting links from downloaded articles
+ * Links are taken with the fast tokenizer, pages it cannot follow
+ * are cleaned with libtidy first.
+ * @param from_which_tags xpath of the nodes from which links are taken
+ * @return pipeline preparing the html code and extracting links
+ */
+PagePipeline PagePipeline::createLinkPipeline(const std::string &from_which_tags) {
+    ExtractLinksStage *extract = new ExtractLinksStage(from_which_tags);
+    extract->addSource(new TokenizerEventSource()).addSource(new TidyEventSource());
+    PagePipeline pipeline;
+    pipeline.add(new PreparePageStage()).add(extract);
+    return pipeline;
+}
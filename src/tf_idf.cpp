@@ -0,0 +1,70 @@
+#include "bayesian_webclass/tf_idf.h"
+#include <algorithm>
+#include <cmath>
+
+
+/** \brief Constructor, without learned frequencies apply does nothing.
+ */
+
+TfIdf::TfIdf() {}
+
+/** \brief Learn the inverse document frequencies.
+ * idf = log((1 + documents) / (1 + documents with the term)) + 1,
+ * so a term found in every document still has a positive weight.
+ * @param documents training documents
+ * @param terms number of terms, ids in documents are lower
+ */
+
+void TfIdf::fit(const std::vector<TermVector>& documents, std::size_t terms) {
+    std::vector<int> df(terms, 0);
+    for(const TermVector& doc : documents) {
+        for(const std::pair<int, float>& t : doc) {
+            if(t.second > 0.0f)
+                ++df[t.first];
+        }
+    }
+    _idf.resize(terms);
+    const double n = static_cast<double>(documents.size());
+    for(std::size_t t = 0; t < terms; ++t) {
+        _idf[t] = static_cast<float>(std::log((1.0 + n) / (1.0 + df[t])) + 1.0);
+    }
+}
+
+/** \brief Weight the document.
+ * @param document term counts, replaced by the TF-IDF weights of
+ *        unit length; terms unknown at fit keep the idf of 1
+ */
+
+void TfIdf::apply(TermVector& document) const {
+    if(_idf.empty())
+        return;
+    double norm = 0.0;
+    for(std::pair<int, float>& t : document) {
+        float idf = static_cast<std::size_t>(t.first) < _idf.size() ? _idf[t.first] : 1.0f;
+        t.second = static_cast<float>(std::log1p(t.second)) * idf;
+        norm += static_cast<double>(t.second) * t.second;
+    }
+    if(norm > 0.0) {
+        const float scale = static_cast<float>(1.0 / std::sqrt(norm));
+        for(std::pair<int, float>& t : document)
+            t.second *= scale;
+    }
+}
+
+/** \brief Count the terms.
+ * @param ids term ids with repetitions, sorted here
+ * @return term vector with the number of occurrences of every term
+ */
+
+TermVector TfIdf::toTerms(std::vector<int>& ids) {
+    std::sort(ids.begin(), ids.end());
+    TermVector terms;
+    for(std::size_t i = 0; i < ids.size(); ) {
+        std::size_t j = i;
+        while(j < ids.size() && ids[j] == ids[i])
+            ++j;
+        terms.push_back(std::make_pair(ids[i], static_cast<float>(j - i)));
+        i = j;
+    }
+    return terms;
+}
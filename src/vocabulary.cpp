@@ -0,0 +1,155 @@
+#include "bayesian_webclass/vocabulary.h"
+#include "bayesian_webclass/fnv_hash.h"
+#include <fstream>
+
+
+/** \brief Constructor, an empty vocabulary.
+ */
+
+Vocabulary::Vocabulary() : _offsets(1, 0), _slots(16, -1) {}
+
+/** \brief Add the word.
+ * @param word word to add, copied into the arena
+ * @return id of the word, the existing one if it was added before
+ */
+
+int Vocabulary::add(view word) {
+    std::uint64_t h = hash(word);
+    std::size_t slot = findSlot(word, h);
+    if(_slots[slot] >= 0)
+        return _slots[slot];
+
+    int id = static_cast<int>(_hashes.size());
+    _arena.append(word.data(), word.size());
+    _offsets.push_back(static_cast<std::uint32_t>(_arena.size()));
+    _hashes.push_back(h);
+    _slots[slot] = id;
+    if(2 * _hashes.size() > _slots.size())
+        rehash(2 * _slots.size());
+    return id;
+}
+
+/** \brief Find the id of the word.
+ * @param word searched word
+ * @return id of the word, -1 if it is not in the vocabulary
+ */
+
+int Vocabulary::find(view word) const {
+    return _slots[findSlot(word, hash(word))];
+}
+
+/** \brief Get the word with the given id.
+ * @param id id of the word, 0 <= id < size()
+ * @return view of the word, valid until the vocabulary is changed
+ */
+
+Vocabulary::view Vocabulary::getWord(int id) const {
+    return view(_arena.data() + _offsets[id], _offsets[id + 1] - _offsets[id]);
+}
+
+/** \brief Number of words.
+ */
+
+std::size_t Vocabulary::size() const {
+    return _hashes.size();
+}
+
+/** \brief Check if there are no words.
+ */
+
+bool Vocabulary::empty() const {
+    return _hashes.empty();
+}
+
+/** \brief Remove all words.
+ */
+
+void Vocabulary::clear() {
+    _arena.clear();
+    _offsets.assign(1, 0);
+    _hashes.clear();
+    _slots.assign(16, -1);
+}
+
+/** \brief Add the words from a file.
+ * Words are separated by white space, like in all_atributes.txt.txt.
+ * @param filename name of the file with words
+ * @return false if the file cannot be opened
+ */
+
+bool Vocabulary::load(const std::string& filename) {
+    std::ifstream input(filename);
+    if(!input.is_open())
+        return false;
+    std::string word;
+    while(input >> word) {
+        add(word);
+    }
+    return true;
+}
+
+/** \brief Write the words to a file, one per line, in the order of ids.
+ * @param filename name of the file
+ * @return false if the file cannot be written
+ */
+
+bool Vocabulary::save(const std::string& filename) const {
+    std::ofstream output(filename);
+    for(std::size_t i = 0; i < size() && output; ++i) {
+        output << getWord(i) << '\n';
+    }
+    return static_cast<bool>(output);
+}
+
+/** \brief Copy the words, in the order of ids.
+ */
+
+std::vector<std::string> Vocabulary::getWords() const {
+    std::vector<std::string> words;
+    words.reserve(size());
+    for(std::size_t i = 0; i < size(); ++i) {
+        words.push_back(getWord(i).to_string());
+    }
+    return words;
+}
+
+/** \brief FNV-1a hash of the word.
+ */
+
+std::uint64_t Vocabulary::hash(view word) {
+    return fnv1a(word.data(), word.size());
+}
+
+/** \brief Grow the hash table and put the ids in it again.
+ * @param slots new number of slots, a power of two
+ */
+
+void Vocabulary::rehash(std::size_t slots) {
+    std::vector<std::int32_t> table(slots, -1);
+    const std::size_t mask = slots - 1;
+    for(std::size_t id = 0; id < _hashes.size(); ++id) {
+        std::size_t slot = _hashes[id] & mask;
+        while(table[slot] >= 0)
+            slot = (slot + 1) & mask;
+        table[slot] = static_cast<std::int32_t>(id);
+    }
+    _slots.swap(table);
+}
+
+/** \brief Find the slot of the word, or the empty slot where it belongs.
+ * @param word searched word
+ * @param h hash of the word
+ * @return index of the slot
+ */
+
+std::size_t Vocabulary::findSlot(view word, std::uint64_t h) const {
+    const std::size_t mask = _slots.size() - 1;
+    std::size_t slot = h & mask;
+    while(_slots[slot] >= 0) {
+        int id = _slots[slot];
+        if(_hashes[id] == h && getWord(id) == word)
+            return slot;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include <bayesian_webclass/async_downloader.h>
+#include <bayesian_webclass/bounded_queue.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//local HTTP stand-in: answers every request with its path as the body, after a short delay;
+//HEAD is answered with 405 when reject_head is set
+struct LocalServer
+{
+    int fd;
+    int port;
+    std::atomic<int> active;
+    std::atomic<int> max_active;
+    std::atomic<bool> stop;
+    std::atomic<bool> reject_head;
+    std::atomic<int> heads;
+    std::thread thread;
+    std::mutex lock;
+    std::string last_request;
+
+    LocalServer() : fd(socket(AF_INET, SOCK_STREAM, 0)), port(0), active(0), max_active(0), stop(false), reject_head(false), heads(0)
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(fd, (sockaddr *) &addr, len);
+        listen(fd, 64);
+        getsockname(fd, (sockaddr *) &addr, &len);
+        port = ntohs(addr.sin_port);
+        thread = std::thread(&LocalServer::accept_loop, this);
+    }
+
+    ~LocalServer()
+    {
+        stop = true;
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+        thread.join();
+    }
+
+    std::string url(const std::string &path) const
+    {
+        return "http://127.0.0.1:" + std::to_string(port) + path;
+    }
+
+    void accept_loop()
+    {
+        std::vector<std::thread> clients;
+        while (!stop)
+        {
+            int client = accept(fd, nullptr, nullptr);
+            if (client < 0)
+                break;
+            clients.push_back(std::thread(&LocalServer::serve, this, client));
+        }
+        for (std::thread &t : clients)
+            t.join();
+    }
+
+    void serve(int client)
+    {
+        int now = ++active;
+        for (int m = max_active; now > m && !max_active.compare_exchange_weak(m, now);)
+        {
+        }
+        char buf[4096];
+        std::string request;
+        ssize_t n;
+        while (request.find("\r\n\r\n") == std::string::npos && (n = read(client, buf, sizeof(buf))) > 0)
+            request.append(buf, n);
+        bool head = request.compare(0, 5, "HEAD ") == 0;
+        heads += head;
+        std::string::size_type begin = head ? 5 : 4;
+        std::string path = request.substr(begin, request.find(' ', begin) - begin);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            last_request = request;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        --active;
+        std::string response = "HTTP/1.0 200 OK\r\nContent-Length: " + std::to_string(path.size()) +
+                               "\r\nConnection: close\r\n\r\n" + (head ? std::string() : path);
+        if (head && reject_head)
+            response = "HTTP/1.0 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        write(client, response.data(), response.size());
+        close(client);
+    }
+};
+
+TEST(AsyncDownloaderTest, DownloadsAllWithinHostLimit)
+{
+    LocalServer server;
+    AsyncDownloader downloader(16, 3);
+    std::vector<std::string> bodies(20);
+    int callbacks = 0;
+    for (int i = 0; i < 20; ++i)
+    {
+        downloader.add(server.url("/page" + std::to_string(i)),
+                       [&bodies, &callbacks, i](const std::string &, bool success, std::string &body) {
+                           EXPECT_TRUE(success);
+                           bodies[i] = body;
+                           ++callbacks;
+                       });
+    }
+    downloader.run();
+
+    EXPECT_EQ(20, callbacks);
+    EXPECT_EQ(0u, downloader.pending());
+    for (int i = 0; i < 20; ++i)
+    {
+        EXPECT_EQ("/page" + std::to_string(i), bodies[i]);
+    }
+    EXPECT_LE(server.max_active, 3);
+    EXPECT_GT(server.max_active, 1);
+}
+
+TEST(AsyncDownloaderTest, FailedDownload)
+{
+    AsyncDownloader downloader;
+    bool called = false;
+    downloader.add("http://127.0.0.1:1/", [&called](const std::string &, bool success, std::string &) {
+        EXPECT_FALSE(success);
+        called = true;
+    });
+    downloader.run();
+    EXPECT_TRUE(called);
+}
+
+TEST(AsyncDownloaderTest, SharedSession)
+{
+    LocalServer server;
+    std::shared_ptr<DownloadSession> session = std::make_shared<DownloadSession>();
+    AsyncDownloader first(4, 2, 5, session), second(4, 2, 5, session);
+    int downloaded = 0;
+    for (AsyncDownloader *downloader : {&first, &second})
+    {
+        downloader->add(server.url("/shared"), [&downloaded](const std::string &, bool success, std::string &body) {
+            EXPECT_TRUE(success);
+            EXPECT_EQ("/shared", body);
+            ++downloaded;
+        });
+        downloader->run();
+    }
+    EXPECT_EQ(2, downloaded);
+    std::lock_guard<std::mutex> guard(server.lock);
+    EXPECT_NE(std::string::npos, server.last_request.find("Accept-Encoding:"));
+    EXPECT_NE(std::string::npos, server.last_request.find("gzip"));
+}
+
+TEST(AsyncDownloaderTest, CheckFallsBackFromHead)
+{
+    LocalServer server;
+    AsyncDownloader downloader;
+    std::map<std::string, long> statuses;
+    AsyncDownloader::CheckCallback record = [&statuses](const std::string &url, long status, double seconds) {
+        EXPECT_GE(seconds, 0.0);
+        statuses[url] = status;
+    };
+    downloader.check(server.url("/head"), record);
+    downloader.check("http://127.0.0.1:1/", record);
+    downloader.run();
+    EXPECT_EQ(200, statuses[server.url("/head")]);
+    EXPECT_EQ(0, statuses["http://127.0.0.1:1/"]);
+    EXPECT_EQ(1, server.heads);
+
+    server.reject_head = true;
+    downloader.check(server.url("/get"), record);
+    downloader.run();
+    EXPECT_EQ(200, statuses[server.url("/get")]);
+    EXPECT_EQ(2, server.heads);
+    std::lock_guard<std::mutex> guard(server.lock);
+    EXPECT_EQ(0u, server.last_request.find("GET /get"));
+    EXPECT_NE(std::string::npos, server.last_request.find("Range: bytes=0-0"));
+}
+
+TEST(AsyncDownloaderTest, SourceFromSlowProducer)
+{
+    LocalServer server;
+    AsyncDownloader downloader;
+    BoundedQueue<std::string> urls(2);
+    std::atomic<bool> produced(false);
+    std::thread producer([&]() {
+        for (int i = 0; i < 6; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            urls.push(server.url("/slow" + std::to_string(i)));
+            downloader.wakeup();
+        }
+        produced = true;
+        urls.close();
+        downloader.wakeup();
+    });
+    int downloaded = 0;
+    bool before_end = false; //the first page is delivered while the producer is still running
+    downloader.run([&]() {
+        std::string url;
+        while (urls.tryPop(url))
+        {
+            downloader.add(url, [&](const std::string &, bool success, std::string &) {
+                EXPECT_TRUE(success);
+                before_end = before_end || (downloaded == 0 && !produced);
+                ++downloaded;
+            });
+        }
+        return !urls.drained();
+    });
+    producer.join();
+    EXPECT_EQ(6, downloaded);
+    EXPECT_TRUE(before_end);
+}
+
+TEST(AsyncDownloaderTest, Host)
+{
+    EXPECT_EQ("https://en.wikipedia.org", AsyncDownloader::getHost("https://en.wikipedia.org/wiki/Black_hole"));
+    EXPECT_EQ("http://127.0.0.1:8080", AsyncDownloader::getHost("http://127.0.0.1:8080?a=1"));
+    EXPECT_EQ("en.wikipedia.org", AsyncDownloader::getHost("en.wikipedia.org/wiki/Star"));
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+        return RUN_ALL_TESTS();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Unhandled Exception: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <bayesian_webclass/bounded_queue.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(BoundedQueueTest, KeepsOrderAndDrainsAfterClose)
+{
+    BoundedQueue<int> queue(4);
+    std::atomic<int> pushed(0);
+    std::thread producer([&queue, &pushed]() {
+        for (int i = 0; i < 100; ++i)
+        {
+            queue.push(i);
+            ++pushed;
+        }
+        queue.close();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LE(pushed, 4); //producer waits for the consumer
+    EXPECT_LE(queue.size(), 4u);
+
+    std::vector<int> popped;
+    int item;
+    while (queue.pop(item))
+        popped.push_back(item);
+    producer.join();
+    ASSERT_EQ(100u, popped.size());
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(i, popped[i]);
+    EXPECT_FALSE(queue.push(100));
+}
+
+TEST(BoundedQueueTest, TryPopDoesNotWait)
+{
+    BoundedQueue<int> queue(2);
+    int item = 0;
+    EXPECT_FALSE(queue.tryPop(item));
+    EXPECT_FALSE(queue.drained());
+    queue.push(7);
+    queue.close();
+    EXPECT_FALSE(queue.drained());
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(7, item);
+    EXPECT_FALSE(queue.tryPop(item));
+    EXPECT_TRUE(queue.drained());
+}
+
+TEST(BoundedQueueTest, ManyProducers)
+{
+    BoundedQueue<int> queue(8);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p)
+    {
+        producers.push_back(std::thread([&queue, p]() {
+            for (int i = 0; i < 1000; ++i)
+                queue.push(p * 1000 + i);
+        }));
+    }
+    std::thread closer([&queue, &producers]() {
+        for (std::thread &t : producers)
+            t.join();
+        queue.close();
+    });
+    std::vector<char> seen(4000, 0);
+    int item, count = 0;
+    while (queue.pop(item))
+    {
+        ++seen[item];
+        ++count;
+    }
+    closer.join();
+    EXPECT_EQ(4000, count);
+    for (char s : seen)
+        EXPECT_EQ(1, s);
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+        return RUN_ALL_TESTS();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Unhandled Exception: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,830 @@
+#include <gtest/gtest.h>
+#include <bayesian_webclass/classifier.h>
+#include <bayesian_webclass/dictionary.h>
+#include <bayesian_webclass/hierarchical_classifier.h>
+#include <bayesian_webclass/model_snapshot.h>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
+
+struct ClassifierTest : ::testing::Test
+{
+    static const int examples_num = 224;
+    std::unique_ptr<Classifier> classifier;
+
+    ClassifierTest() : classifier(new Classifier())
+    {
+        EXPECT_TRUE(classifier->init("../txt/all_atributes.txt.txt",
+                                     "../txt/categories/list_of_categories.txt",
+                                     "../txt/output/",
+                                     examples_num));
+    };
+
+    //attributes of the example from txt/output, without the category in the first line
+    static std::set<std::string> loadAttribs(int i, std::string &category)
+    {
+        std::ifstream input("../txt/output/" + std::to_string(i) + ".txt");
+        std::set<std::string> attribs;
+        std::string word;
+        input >> category;
+        while (input >> word)
+        {
+            attribs.insert(word);
+        }
+        return attribs;
+    }
+};
+
+TEST_F(ClassifierTest, SparseMatchesReference)
+{
+    for (int i = 0; i <= examples_num; ++i)
+    {
+        std::string category;
+        std::set<std::string> attribs = loadAttribs(i, category);
+        EXPECT_EQ(classifier->classifyReference(attribs), classifier->classify(attribs)) << "example " << i;
+    }
+}
+
+TEST_F(ClassifierTest, EmptyExample)
+{
+    std::set<std::string> attribs;
+    EXPECT_EQ(classifier->classifyReference(attribs), classifier->classify(attribs));
+}
+
+TEST_F(ClassifierTest, BatchMatchesClassify)
+{
+    std::vector<std::string> documents;
+    std::vector<std::set<std::string>> examples;
+    for (int i = 0; i <= examples_num; ++i)
+    {
+        std::string category, document;
+        examples.push_back(loadAttribs(i, category));
+        for (const std::string &word : examples.back())
+        {
+            document += word + "\n";
+        }
+        documents.push_back(document);
+    }
+
+    std::vector<BatchResult> results = classifier->classifyBatch(documents, 4);
+    ASSERT_EQ(documents.size(), results.size());
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        EXPECT_EQ(classifier->classify(examples[i]), results[i].category) << "example " << i;
+        double sum = 0.0;
+        for (double b : results[i].beliefs)
+        {
+            sum += b;
+        }
+        EXPECT_NEAR(1.0, sum, 1e-9) << "example " << i;
+    }
+}
+
+TEST(ClassifierInitTest, FailsOnMissingExample)
+{
+    Classifier partial;
+    EXPECT_FALSE(partial.init("../txt/all_atributes.txt.txt",
+                              "../txt/categories/list_of_categories.txt",
+                              "../txt/output/",
+                              300, 2));  //no examples after 224
+    HierarchicalClassifier hierarchical;
+    EXPECT_FALSE(hierarchical.init("../txt/all_atributes.txt.txt",
+                                   "../txt/categories/list_of_categories.txt",
+                                   "../txt/categories/category_tree.txt",
+                                   "../txt/output/",
+                                   300, 2));
+}
+
+TEST_F(ClassifierTest, ThreadsDoNotChangeModel)
+{
+    Classifier single;
+    ASSERT_TRUE(single.init("../txt/all_atributes.txt.txt",
+                            "../txt/categories/list_of_categories.txt",
+                            "../txt/output/",
+                            examples_num, 1));
+    std::vector<std::string> files;
+    std::vector<BatchResult> expected = single.classifyDirectory("../txt/output/", files, 1);
+    std::vector<BatchResult> results = classifier->classifyDirectory("../txt/output/", files, 1);
+    ASSERT_EQ(expected.size(), results.size());
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].beliefs, results[i].beliefs) << files[i];
+    }
+}
+
+TEST_F(ClassifierTest, TrainFromMergedShards)
+{
+    Classifier sharded;
+    sharded.loadAttributes("../txt/all_atributes.txt.txt");
+    sharded.loadCategories("../txt/categories/list_of_categories.txt");
+    CountTable first, second, merged;
+    ASSERT_TRUE(sharded.countExamples("../txt/output/", 0, 99, first, 2));
+    ASSERT_TRUE(sharded.countExamples("../txt/output/", 100, examples_num, second, 3));
+    ASSERT_TRUE(first.save("first.counts"));
+    ASSERT_TRUE(second.save("second.counts"));
+    ASSERT_TRUE(merged.load("first.counts"));
+    ASSERT_TRUE(second.load("second.counts"));
+    ASSERT_TRUE(merged.merge(second));
+    EXPECT_FALSE(merged.merge(CountTable(merged.getCategoryCount(), merged.getAttributeCount(), 1)));
+    EXPECT_FALSE(sharded.trainFromCounts(CountTable(1, 1)));
+    EXPECT_FALSE(sharded.trainFromCounts(CountTable(merged.getCategoryCount(), merged.getAttributeCount())));
+    ASSERT_TRUE(sharded.trainFromCounts(first));
+    ASSERT_TRUE(sharded.trainFromCounts(merged));     //replaces the model, does not add to it
+    std::remove("first.counts");
+    std::remove("second.counts");
+
+    std::vector<std::string> files;
+    std::vector<BatchResult> expected = classifier->classifyDirectory("../txt/output/", files, 1);
+    std::vector<BatchResult> results = sharded.classifyDirectory("../txt/output/", files, 1);
+    ASSERT_EQ(expected.size(), results.size());
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].beliefs, results[i].beliefs) << files[i];
+    }
+}
+
+TEST_F(ClassifierTest, LearnMatchesTraining)
+{
+    const int trained_num = 180;
+    Classifier online;
+    ASSERT_TRUE(online.init("../txt/all_atributes.txt.txt",
+                            "../txt/categories/list_of_categories.txt",
+                            "../txt/output/",
+                            trained_num));
+    EXPECT_FALSE(online.learn(std::set<std::string>(), "no_such_category"));
+    std::string first_category;
+    std::set<std::string> first = loadAttribs(0, first_category);
+    std::atomic<bool> learning(true);
+    std::thread reader([&]
+    {
+        while (learning)    //classification goes on while the model is updated
+        {
+            EXPECT_FALSE(online.classify(first).empty());
+            EXPECT_FALSE(online.classifyReference(first).empty());
+        }
+    });
+    for (int i = trained_num + 1; i <= examples_num; ++i)
+    {
+        std::string category;
+        std::set<std::string> attribs = loadAttribs(i, category);
+        EXPECT_TRUE(online.learn(attribs, category));
+    }
+    learning = false;
+    reader.join();
+
+    std::vector<std::string> files;
+    std::vector<BatchResult> expected = classifier->classifyDirectory("../txt/output/", files, 1);
+    std::vector<BatchResult> results = online.classifyDirectory("../txt/output/", files, 1);
+    ASSERT_EQ(expected.size(), results.size());
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].category, results[i].category) << files[i];
+        for (std::size_t c = 0; c < results[i].beliefs.size(); ++c)
+        {
+            EXPECT_NEAR(expected[i].beliefs[c], results[i].beliefs[c], 1e-9) << files[i];
+        }
+    }
+    for (int i = 0; i <= examples_num; i += 16)
+    {
+        std::string category;
+        std::set<std::string> attribs = loadAttribs(i, category);
+        EXPECT_EQ(classifier->classifyReference(attribs), online.classifyReference(attribs)) << i;
+    }
+}
+
+TEST_F(ClassifierTest, MultinomialBatchMatchesClassify)
+{
+    ASSERT_TRUE(classifier->trainMultinomial("../txt/output/", 0, examples_num, MultinomialModel::COMPLEMENT, true));
+    std::vector<std::string> files;
+    std::vector<BatchResult> results = classifier->classifyDirectory("../txt/output/", files, 2);
+    ASSERT_EQ(files.size(), results.size());
+    int correct = 0;
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        std::string category;
+        std::set<std::string> attribs;
+        std::ifstream input(files[i]);
+        input >> category;
+        attribs.insert(category);   //the first word is classified as well
+        for (std::string word; input >> word;)
+        {
+            attribs.insert(word);
+        }
+        EXPECT_EQ(classifier->classify(attribs), results[i].category) << files[i];
+        correct += results[i].category == category;
+        double sum = 0.0;
+        for (double b : results[i].beliefs)
+        {
+            sum += b;
+        }
+        EXPECT_NEAR(1.0, sum, 1e-9) << files[i];
+    }
+    EXPECT_GT(correct, static_cast<int>(results.size()) / 2);   //training examples
+}
+
+TEST_F(ClassifierTest, TopMatchesClassify)
+{
+    for (int i = 1; i <= examples_num; i += 7)
+    {
+        std::string category;
+        std::set<std::string> attribs = loadAttribs(i, category);
+        std::vector<CategoryScore> best = classifier->classifyTop(attribs, 3);
+        ASSERT_EQ(3u, best.size());
+        EXPECT_EQ(classifier->classify(attribs), classifier->getCategoryName(best[0].first)) << "example " << i;
+        EXPECT_GE(best[0].second, best[1].second);
+        EXPECT_GE(best[1].second, best[2].second);
+        EXPECT_NE(best[0].first, best[1].first);
+    }
+}
+
+TEST_F(ClassifierTest, FlatTreeMatchesClassifier)
+{
+    const std::string tree = "hierarchical_gtest_tree.txt";
+    std::ofstream(tree).close();    //no pairs, every category under the root
+    HierarchicalClassifier hierarchical;
+    ASSERT_TRUE(hierarchical.init("../txt/all_atributes.txt.txt",
+                                  "../txt/categories/list_of_categories.txt",
+                                  tree, "../txt/output/", examples_num, 2));
+    std::remove(tree.c_str());
+    EXPECT_EQ(1u, hierarchical.getDepth());
+    for (int i = 0; i <= examples_num; i += 5)
+    {
+        std::string category;
+        std::set<std::string> attribs = loadAttribs(i, category);
+        EXPECT_EQ(classifier->classify(attribs), hierarchical.classify(attribs)) << "example " << i;
+    }
+}
+
+TEST_F(ClassifierTest, HierarchicalDescendsTree)
+{
+    HierarchicalClassifier hierarchical;
+    ASSERT_TRUE(hierarchical.init("../txt/all_atributes.txt.txt",
+                                  "../txt/categories/list_of_categories.txt",
+                                  "../txt/categories/category_tree.txt",
+                                  "../txt/output/", examples_num));
+    EXPECT_EQ(4u, hierarchical.getDepth());
+    int greedy = 0, beam = 0;
+    for (int i = 0; i <= examples_num; ++i)
+    {
+        std::string category;
+        std::set<std::string> attribs = loadAttribs(i, category);
+        greedy += hierarchical.classify(attribs) == category;
+        beam += hierarchical.classify(attribs, 3) == category;
+    }
+    EXPECT_GT(greedy, examples_num / 3);   //the flat classifier: a half of the examples
+    EXPECT_GT(beam, examples_num / 3);
+}
+
+TEST(HierarchicalClassifierTest, RejectsInvalidTree)
+{
+    const std::string tree = "hierarchical_gtest_tree.txt";
+    std::vector<std::string> categories = {"a", "b"};
+    HierarchicalClassifier hierarchical;
+    std::ofstream(tree) << "x a\ny a\n";     //two parents
+    EXPECT_FALSE(hierarchical.loadTree(tree, categories));
+    std::ofstream(tree) << "x y\ny x\n";     //cycle
+    EXPECT_FALSE(hierarchical.loadTree(tree, categories));
+    std::ofstream(tree) << "a x\n";          //leaf which is not a category
+    EXPECT_FALSE(hierarchical.loadTree(tree, categories));
+    std::ofstream(tree) << "x a\n\nx b\n";
+    EXPECT_TRUE(hierarchical.loadTree(tree, categories));
+    EXPECT_EQ(4u, hierarchical.getNodeCount());
+    EXPECT_EQ(2u, hierarchical.getDepth());
+    std::remove(tree.c_str());
+    EXPECT_FALSE(hierarchical.loadTree(tree, categories));
+}
+
+TEST_F(ClassifierTest, SnapshotRejectsInvalidHeader)
+{
+    const std::string filename = "classifier_gtest.snapshot";
+    ASSERT_TRUE(classifier->saveSnapshot(filename));
+    ModelSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(filename));
+    std::string category;
+    std::set<std::string> attribs = loadAttribs(1, category);
+    EXPECT_EQ(classifier->classify(attribs), snapshot.classify(attribs));
+    snapshot.close();
+
+    std::string data;
+    {
+        std::ifstream input(filename, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    auto rewrite = [&filename](const std::string &bytes) {
+        std::ofstream(filename, std::ios::binary | std::ios::trunc) << bytes;
+    };
+
+    std::string corrupted = data;
+    std::memset(&corrupted[16], 0, sizeof(std::uint32_t));     //no categories
+    rewrite(corrupted);
+    EXPECT_FALSE(snapshot.open(filename));
+
+    corrupted = data;
+    std::uint64_t category_names;
+    std::memcpy(&category_names, &corrupted[32], sizeof(category_names));
+    std::uint32_t second;
+    std::memcpy(&second, &corrupted[category_names + sizeof(std::uint32_t)], sizeof(second));
+    second += 1;    //the first name would end before it starts
+    std::memcpy(&corrupted[category_names], &second, sizeof(second));
+    rewrite(corrupted);
+    EXPECT_FALSE(snapshot.open(filename));
+
+    rewrite(data);
+    EXPECT_TRUE(snapshot.open(filename));
+    std::remove(filename.c_str());
+}
+
+TEST(CountTableTest, CountersMatchTraining)
+{
+    int A[] = {0, 1};
+    int C[] = {0, 1};
+    Domains attribs;
+    attribs.push_back(faif::createDomain("a", A, A + 2));
+    attribs.push_back(faif::createDomain("b", A, A + 2));
+    attribs.push_back(faif::createDomain("c", A, A + 2));
+    AttrDomain cat = faif::createDomain("", C, C + 2);
+    NBint trained(attribs, cat);
+    NBint counted(attribs, cat);
+
+    int examples[][4] = {{1, 0, 1, 0}, {1, 1, 0, 0}, {0, 0, 1, 1}, {1, 0, 1, 1}, {0, 0, 0, 0}};
+    CountTable first(2, 3), second(2, 3);
+    for (int i = 0; i < 5; ++i)
+    {
+        trained.trainIncremental(faif::ml::createExample(examples[i], examples[i] + 3, examples[i][3], trained));
+        SparseExample ex;
+        for (int a = 0; a < 3; ++a)
+        {
+            if (examples[i][a])
+                ex.push_back(a);
+        }
+        (i % 2 ? first : second).add(examples[i][3], ex);
+    }
+    ASSERT_TRUE(first.merge(second));
+    EXPECT_FALSE(first.merge(CountTable(2, 4)));
+    EXPECT_EQ(3, first.getExamples(0));
+    EXPECT_EQ(2, first.getCount(1, 2));
+
+    for (int c = 0; c < 2; ++c)
+    {
+        NBint::ValueCounters counters;
+        int a = 0;
+        for (const AttrDomain &attr : counted.getAttrDomains())
+        {
+            counters.push_back(std::make_pair(attr.find(1), first.getCount(c, a)));
+            counters.push_back(std::make_pair(attr.find(0), first.getExamples(c) - first.getCount(c, a)));
+            ++a;
+        }
+        counted.addCounters(counted.getCategoryDomain().find(c), first.getExamples(c), counters);
+    }
+
+    EXPECT_THROW(trained.getCategoryLogProbability(trained.getCategoryDomain().find(0)), faif::ml::ModelNotFrozenException);
+    trained.freeze();
+    counted.freeze();
+    for (int c = 0; c < 2; ++c)
+    {
+        EXPECT_DOUBLE_EQ(trained.getCategoryLogProbability(trained.getCategoryDomain().find(c)),
+                         counted.getCategoryLogProbability(counted.getCategoryDomain().find(c)));
+        Domains::const_iterator t = trained.getAttrDomains().begin();
+        for (const AttrDomain &attr : counted.getAttrDomains())
+        {
+            for (int v = 0; v < 2; ++v)
+            {
+                EXPECT_DOUBLE_EQ(trained.getValueLogProbability(trained.getCategoryDomain().find(c), t->find(v)),
+                                 counted.getValueLogProbability(counted.getCategoryDomain().find(c), attr.find(v)));
+            }
+            ++t;
+        }
+    }
+}
+
+TEST(NaiveBayesianTest, OnlineLearningKeepsCounters)
+{
+    int A[] = {0, 1, 2};
+    int C[] = {0, 1};
+    Domains attribs;
+    attribs.push_back(faif::createDomain("a", A, A + 2));
+    attribs.push_back(faif::createDomain("b", A, A + 3));
+    AttrDomain cat = faif::createDomain("", C, C + 2);
+    NBint online(attribs, cat);
+    NBint batch(attribs, cat);
+
+    int examples[][3] = {{1, 0, 0}, {1, 2, 0}, {0, 1, 1}, {1, 1, 1}, {0, 2, 0}, {0, 0, 1}};
+    for (int i = 0; i < 6; ++i)
+    {
+        NBint::ExampleTrain ex = faif::ml::createExample(examples[i], examples[i] + 2, examples[i][2], batch);
+        batch.trainIncremental(ex);
+        online.trainIncremental(faif::ml::createExample(examples[i], examples[i] + 2, examples[i][2], online));
+        if (i == 2)
+        {
+            online.switchClassify();  //classify state, still learns online
+        }
+    }
+    online.freeze();
+    EXPECT_THROW(online.trainIncremental(faif::ml::createExample(examples[0], examples[0] + 2, examples[0][2], online)),
+                 faif::ml::ModelFrozenException);
+
+    batch.freeze();
+    for (int c = 0; c < 2; ++c)
+    {
+        EXPECT_NEAR(batch.getCategoryLogProbability(batch.getCategoryDomain().find(c)),
+                    online.getCategoryLogProbability(online.getCategoryDomain().find(c)), 1e-12);
+        Domains::const_iterator b = batch.getAttrDomains().begin();
+        for (const AttrDomain &attr : online.getAttrDomains())
+        {
+            for (AttrDomain::const_iterator v = attr.begin(); v != attr.end(); ++v)
+            {
+                EXPECT_NEAR(batch.getValueLogProbability(batch.getCategoryDomain().find(c), b->find(v->get())),
+                            online.getValueLogProbability(online.getCategoryDomain().find(c), AttrDomain::getValueId(v)), 1e-12);
+            }
+            ++b;
+        }
+    }
+}
+
+TEST(NaiveBayesianTest, SerializationKeepsCounters)
+{
+    int A[] = {0, 1, 2};
+    int C[] = {0, 1};
+    Domains attribs;
+    attribs.push_back(faif::createDomain("a", A, A + 2));
+    attribs.push_back(faif::createDomain("b", A, A + 3));
+    AttrDomain cat = faif::createDomain("", C, C + 2);
+    NBint trained(attribs, cat);
+    int examples[][3] = {{1, 0, 0}, {1, 2, 0}, {0, 1, 1}, {1, 1, 1}, {0, 2, 0}, {0, 0, 1}};
+    for (int i = 0; i < 6; ++i)
+    {
+        trained.trainIncremental(faif::ml::createExample(examples[i], examples[i] + 2, examples[i][2], trained));
+    }
+    trained.switchClassify();
+    std::stringstream archive;
+    {
+        boost::archive::text_oarchive oa(archive);
+        const NBint &saved = trained;
+        oa << saved;
+    }
+
+    //the classify state saved before the counters were kept (version 0, the log-probabilities only)
+    std::istringstream old_archive(
+        "22 serialization::archive 18 1 0\n"
+        "0 0 0 2 1 0\n"
+        "1 1 a 0 0 2 0 1 0\n"
+        "2 0 3 1\n"
+        "3 1 3 1\n"
+        "4 1 b 3 0\n"
+        "5 0 3 4\n"
+        "6 1 3 4\n"
+        "7 2 3 4\n"
+        "8 0  2 0\n"
+        "9 0 3 8\n"
+        "10 1 3 8 1 1 0\n"
+        "11 1 0\n"
+        "12 0 0 0 0 2 0 0 0 5 9 0 0 -6.93147180559945286e-01 0 0 5 0 0 0 5 2 -9.16290731874154996e-01 5 3 -5.10825623765990722e-01 5 5 -1.09861228866810978e+00 5 6 -1.79175946922805496e+00 5 7 -6.93147180559945286e-01 5 10 -6.93147180559945286e-01 5 0 5 2 -5.10825623765990722e-01 5 3 -9.16290731874154996e-01 5 5 -1.09861228866810978e+00 5 6 -6.93147180559945286e-01 5 7 -1.79175946922805496e+00\n");
+    NBint loaded, old;
+    {
+        boost::archive::text_iarchive ia(archive);
+        ia >> loaded;
+        boost::archive::text_iarchive old_ia(old_archive);
+        old_ia >> old;
+    }
+    for (int c = 0; c < 2; ++c)
+    {
+        NBint::AttrIdd t = trained.getCategoryDomain().find(c);
+        EXPECT_NEAR(trained.getCategoryLogProbability(t), loaded.getCategoryLogProbability(loaded.getCategoryDomain().find(c)), 1e-12);
+        EXPECT_NEAR(trained.getCategoryLogProbability(t), old.getCategoryLogProbability(old.getCategoryDomain().find(c)), 1e-12);
+        EXPECT_NEAR(trained.getValueLogProbability(t, trained.getAttrDomains().front().find(1)),
+                    old.getValueLogProbability(old.getCategoryDomain().find(c), old.getAttrDomains().front().find(1)), 1e-12);
+    }
+
+    trained.trainIncremental(faif::ml::createExample(examples[0], examples[0] + 2, examples[0][2], trained));
+    loaded.trainIncremental(faif::ml::createExample(examples[0], examples[0] + 2, examples[0][2], loaded));
+    EXPECT_NEAR(trained.getCategoryLogProbability(trained.getCategoryDomain().find(0)),
+                loaded.getCategoryLogProbability(loaded.getCategoryDomain().find(0)), 1e-12);
+
+    //the old model has no counters to learn from, it keeps classifying with the loaded probabilities
+    const double old_prob = old.getCategoryLogProbability(old.getCategoryDomain().find(0));
+    EXPECT_THROW(old.trainIncremental(faif::ml::createExample(examples[0], examples[0] + 2, examples[0][2], old)),
+                 faif::ml::ModelWithoutCountersException);
+    EXPECT_THROW(old.addCounters(old.getCategoryDomain().find(0), 1, NBint::ValueCounters()),
+                 faif::ml::ModelWithoutCountersException);
+    EXPECT_EQ(old_prob, old.getCategoryLogProbability(old.getCategoryDomain().find(0)));
+    EXPECT_EQ(1, old.getCategory(faif::ml::createExample(examples[2], examples[2] + 2, old))->get());
+    old.reset();
+    old.trainIncremental(faif::ml::createExample(examples[0], examples[0] + 2, examples[0][2], old));
+    old.freeze();
+    EXPECT_NEAR(std::log(2.0 / 3.0), old.getCategoryLogProbability(old.getCategoryDomain().find(0)), 1e-12);
+}
+
+TEST(NaiveBayesianTest, BeliefsOfLongExample)
+{
+    const int attributes = 3000;
+    int A[] = {0, 1};
+    int C[] = {0, 1, 2};
+    Domains attribs;
+    for (int a = 0; a < attributes; ++a)
+    {
+        attribs.push_back(faif::createDomain(std::to_string(a), A, A + 2));
+    }
+    NBint nb(attribs, faif::createDomain("", C, C + 3));
+    std::vector<int> values(attributes, 0);
+    for (int i = 0; i < 9; ++i)
+    {
+        for (int a = 0; a < attributes; ++a)
+        {
+            values[a] = (a % 3 == i % 3 || a % 7 == i) ? 1 : 0;
+        }
+        nb.trainIncremental(faif::ml::createExample(values.begin(), values.end(), i % 3, nb));
+    }
+    std::fill(values.begin(), values.end(), 1);
+    NBint::ExampleTest example = faif::ml::createExample(values.begin(), values.end(), nb);
+
+    NBint::Beliefs beliefs = nb.getCategories(example);   //log-probabilities about -3000
+    ASSERT_EQ(3u, beliefs.size());
+    double sum = 0.0;
+    for (const NBint::Beliefs::value_type &b : beliefs)
+    {
+        ASSERT_FALSE(std::isnan(b.getProbability()));
+        sum += b.getProbability();
+    }
+    EXPECT_NEAR(1.0, sum, 1e-12);
+    EXPECT_EQ(nb.getCategory(example), beliefs.front().getValue());
+
+    nb.freeze();
+    NBcompiled compiled(nb);
+    std::vector<double> dense(compiled.getCategoriesCount());
+    compiled.getBeliefs(compiled.toDense(example), &dense[0]);
+    for (int c = 0; c < compiled.getCategoriesCount(); ++c)
+    {
+        for (const NBint::Beliefs::value_type &b : beliefs)
+        {
+            if (b.getValue() == compiled.getCategoryIdd(c))
+            {
+                EXPECT_NEAR(b.getProbability(), dense[c], 1e-9);
+            }
+        }
+    }
+}
+
+TEST(NaiveBayesianTest, NormalizeLogProbabilities)
+{
+    double p[] = {-1000.0, -1000.0 - std::log(3.0), -std::numeric_limits<double>::infinity()};
+    EXPECT_NEAR(-1000.0 + std::log(4.0 / 3.0), faif::ml::normalizeLogProbabilities(p, 3), 1e-9);
+    EXPECT_NEAR(0.75, p[0], 1e-12);
+    EXPECT_NEAR(0.25, p[1], 1e-12);
+    EXPECT_EQ(0.0, p[2]);
+}
+
+TEST(BernoulliModelTest, TopMatchesSortedScores)
+{
+    const std::size_t attributes = 100, categories = 400;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> log_prob(-5.0, 0.0);
+    std::vector<double> category_log_prob(categories);
+    std::vector<double> value_log_prob(categories * 2 * attributes);
+    for (double &p : category_log_prob)
+        p = log_prob(random);
+    for (double &p : value_log_prob)
+        p = log_prob(random);
+    category_log_prob[8] = category_log_prob[7];    //equal categories, ties
+    std::copy(&value_log_prob[7 * 2 * attributes], &value_log_prob[8 * 2 * attributes],
+              &value_log_prob[8 * 2 * attributes]);
+    BernoulliModel model;
+    model.build(attributes, categories, &category_log_prob[0], &value_log_prob[0], 2 * attributes);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        SparseExample ex;
+        for (std::size_t a = 0; a < attributes; ++a)
+        {
+            if (random() % 4 == 0)
+                ex.push_back(static_cast<int>(a));
+        }
+        std::vector<double> scores(categories);
+        model.score(ex, &scores[0]);
+        std::vector<CategoryScore> sorted;
+        for (std::size_t c = 0; c < categories; ++c)
+            sorted.push_back(CategoryScore(static_cast<int>(c), scores[c]));
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const CategoryScore &a, const CategoryScore &b) { return a.second > b.second; });
+
+        for (std::size_t k : {std::size_t(1), std::size_t(10), categories, categories + 1})
+        {
+            std::vector<CategoryScore> best;
+            model.top(ex, k, best);
+            ASSERT_EQ(std::min(k, categories), best.size());
+            for (std::size_t j = 0; j < best.size(); ++j)
+            {
+                EXPECT_EQ(sorted[j], best[j]) << "example " << i << ", k " << k << ", place " << j;
+            }
+        }
+        EXPECT_EQ(sorted.front().first, model.classify(ex));
+    }
+    std::vector<CategoryScore> best;
+    BernoulliModel().top(SparseExample(), 3, best);
+    EXPECT_TRUE(best.empty());
+}
+
+TEST(NaiveBayesianTest, CompiledTopCategories)
+{
+    int A[] = {0, 1};
+    int C[] = {0, 1, 2, 3, 4};
+    Domains attribs;
+    for (int a = 0; a < 20; ++a)
+    {
+        attribs.push_back(faif::createDomain(std::to_string(a), A, A + 2));
+    }
+    NBint nb(attribs, faif::createDomain("", C, C + 5));
+    std::vector<int> values(20, 0);
+    for (int i = 0; i < 40; ++i)
+    {
+        for (int a = 0; a < 20; ++a)
+        {
+            values[a] = (a * i) % 5 == 1 ? 1 : 0;
+        }
+        nb.trainIncremental(faif::ml::createExample(values.begin(), values.end(), i % 5, nb));
+    }
+    nb.freeze();
+    NBcompiled compiled(nb);
+    for (int i = 0; i < 10; ++i)
+    {
+        for (int a = 0; a < 20; ++a)
+        {
+            values[a] = (a + i) % 3 == 0 ? 1 : 0;
+        }
+        NBint::ExampleTest example = faif::ml::createExample(values.begin(), values.end(), nb);
+        NBcompiled::DenseExample dense = compiled.toDense(example);
+        std::vector<std::pair<int, double> > best;
+        compiled.getTopCategories(dense, 3, best);
+        ASSERT_EQ(3u, best.size());
+        EXPECT_EQ(nb.getCategory(example), compiled.getCategoryIdd(best[0].first));
+        for (std::size_t j = 0; j < best.size(); ++j)
+        {
+            EXPECT_EQ(compiled.score(dense, best[j].first), best[j].second);
+            if (j > 0)
+            {
+                EXPECT_GE(best[j - 1].second, best[j].second);
+            }
+        }
+        for (int c = 0; c < compiled.getCategoriesCount(); ++c)     //the others are not better
+        {
+            bool in_top = false;
+            for (const std::pair<int, double> &b : best)
+                in_top = in_top || b.first == c;
+            if (!in_top)
+            {
+                EXPECT_LE(compiled.score(dense, c), best.back().second);
+            }
+        }
+    }
+}
+
+TEST(CountTableTest, SaveAndLoad)
+{
+    CountTable table(3, 5, 42);
+    table.add(0, SparseExample{1, 4});
+    table.add(2, SparseExample{0, 1, 2, 3, 4});
+    table.add(2, SparseExample{4});
+    ASSERT_TRUE(table.save("table.counts"));
+
+    CountTable loaded;
+    EXPECT_FALSE(loaded.load("table.counts", 43));
+    ASSERT_TRUE(loaded.load("table.counts", 42));
+    EXPECT_EQ(42u, loaded.getKey());
+    ASSERT_EQ(3u, loaded.getCategoryCount());
+    ASSERT_EQ(5u, loaded.getAttributeCount());
+    for (int c = 0; c < 3; ++c)
+    {
+        EXPECT_EQ(table.getExamples(c), loaded.getExamples(c));
+        for (int a = 0; a < 5; ++a)
+        {
+            EXPECT_EQ(table.getCount(c, a), loaded.getCount(c, a));
+        }
+    }
+
+    std::ofstream("table.counts", std::ios::app) << 'x';
+    EXPECT_FALSE(loaded.load("table.counts"));
+    EXPECT_FALSE(loaded.load("no_such_file.counts"));
+    EXPECT_EQ(2, loaded.getExamples(2));
+    std::remove("table.counts");
+}
+
+TEST(MultinomialModelTest, WeightsAndScore)
+{
+    std::vector<TermVector> documents = {{{0, 2.0f}, {1, 1.0f}}, {{0, 1.0f}}, {{2, 3.0f}}};
+    std::vector<int> labels = {0, 0, 1};
+    MultinomialModel model;
+    model.train(3, 2, documents, labels, MultinomialModel::MULTINOMIAL);
+    EXPECT_FLOAT_EQ(std::log(4.0 / 7.0), model.getWeight(0, 0));
+    EXPECT_FLOAT_EQ(std::log(1.0 / 6.0), model.getWeight(0, 1));
+    EXPECT_FLOAT_EQ(std::log(3.0 / 5.0), model.getBias(0));
+    EXPECT_EQ(0, model.classify({{0, 1.0f}}));
+    EXPECT_EQ(1, model.classify({{2, 1.0f}, {7, 5.0f}}));
+
+    model.train(3, 2, documents, labels, MultinomialModel::COMPLEMENT);
+    EXPECT_FLOAT_EQ(-std::log(1.0 / 6.0), model.getWeight(0, 0));
+    EXPECT_FLOAT_EQ(-std::log(4.0 / 7.0), model.getWeight(0, 1));
+    EXPECT_EQ(0, model.classify({{0, 1.0f}, {1, 1.0f}}));
+    EXPECT_EQ(1, model.classify({{2, 2.0f}}));
+}
+
+TEST(TfIdfTest, WeightsHaveUnitLength)
+{
+    std::vector<int> ids = {2, 0, 2, 2};
+    TermVector counts = TfIdf::toTerms(ids);
+    ASSERT_EQ(2u, counts.size());
+    EXPECT_EQ(std::make_pair(0, 1.0f), counts[0]);
+    EXPECT_EQ(std::make_pair(2, 3.0f), counts[1]);
+
+    TfIdf tfidf;
+    tfidf.apply(counts);    //no frequencies yet
+    EXPECT_EQ(3.0f, counts[1].second);
+    tfidf.fit({{{0, 1.0f}}, {{0, 1.0f}, {1, 2.0f}}, {{2, 1.0f}}}, 3);
+    EXPECT_FLOAT_EQ(1.0f, tfidf.getIdf(0) - std::log(4.0f / 3.0f));
+    EXPECT_FLOAT_EQ(1.0f + std::log(2.0f), tfidf.getIdf(2));
+    tfidf.apply(counts);
+    EXPECT_NEAR(1.0, counts[0].second * counts[0].second + counts[1].second * counts[1].second, 1e-6);
+    EXPECT_GT(counts[1].second, counts[0].second);
+}
+
+TEST(VocabularyTest, AddAndFind)
+{
+    Vocabulary vocabulary;
+    EXPECT_EQ(0, vocabulary.add("alpha"));
+    EXPECT_EQ(1, vocabulary.add("beta"));
+    EXPECT_EQ(0, vocabulary.add("alpha"));
+    EXPECT_EQ(2u, vocabulary.size());
+    EXPECT_EQ(1, vocabulary.find("beta"));
+    EXPECT_EQ(-1, vocabulary.find("gamma"));
+    EXPECT_EQ(-1, vocabulary.find(""));
+    EXPECT_EQ("alpha", vocabulary.getWord(0));
+}
+
+TEST(VocabularyTest, KeepsIdsWhenGrowing)
+{
+    Vocabulary vocabulary;
+    for (int i = 0; i < 10000; ++i)
+    {
+        ASSERT_EQ(i, vocabulary.add("word" + std::to_string(i)));
+    }
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::string word = "word" + std::to_string(i);
+        EXPECT_EQ(i, vocabulary.find(word));
+        EXPECT_EQ(word, vocabulary.getWord(i));
+    }
+    EXPECT_EQ(-1, vocabulary.find("word10000"));
+}
+
+TEST(VocabularyTest, LoadInFileOrder)
+{
+    Vocabulary vocabulary;
+    ASSERT_TRUE(vocabulary.load("../txt/all_atributes.txt.txt"));
+    std::ifstream input("../txt/all_atributes.txt.txt");
+    std::vector<std::string> words;
+    std::string word;
+    while (input >> word)
+    {
+        if (vocabulary.find(word) == static_cast<int>(words.size()))
+        {
+            words.push_back(word);
+        }
+        EXPECT_GE(vocabulary.find(word), 0) << word;
+    }
+    EXPECT_EQ(words, vocabulary.getWords());
+    EXPECT_FALSE(vocabulary.load("no_such_file.txt"));
+}
+
+TEST_F(ClassifierTest, DictionarySharesVocabulary)
+{
+    Dictionary dictionary(classifier->getVocabulary());
+    std::string category;
+    std::set<std::string> attribs = loadAttribs(0, category);
+    int known = 0;
+    for (const std::string &word : attribs)
+    {
+        known += classifier->getVocabulary()->find(word) >= 0;
+    }
+    EXPECT_EQ(known, dictionary.compare("../txt/output/0.txt") - (classifier->getVocabulary()->find(category) >= 0));
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+        return RUN_ALL_TESTS();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Unhandled Exception: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -3,6 +3,7 @@
 //
 #include <gtest/gtest.h>
 #include <bayesian_webclass/csv.h>
+#include <bayesian_webclass/csv_reader.h>
 #include <fstream>
 #include <bayesian_webclass/data_preprocessor.h>
 
@@ -49,9 +50,93 @@ INSTANTIATE_TEST_CASE_P(Default, CsvTest, ::testing::Values(
         csv_content{"data/non_int_id.csv", 0, 2, 0, "", false},
         csv_content{"data/one_non_int_id.csv", 0, 2, 69, "lozko", true},
         csv_content{"data/reverse_formating.csv", 1, 0, 4232, "onet.pl", true},
-        csv_content{"fasdfas",1,3,0,"",false} //wrong file
+        csv_content{"fasdfas",1,3,0,"",false}, //wrong file
+        csv_content{"data/six_invalid_ids.csv", 0, 1, 5, "www.six-invalid-ids-then-a-valid-row.pl", true},
+        csv_content{"data/seven_invalid_ids.csv", 0, 1, 0, "", false}
 ));
 
+TEST(IdUrlMapTest, SortedWithFirstDuplicate)
+{
+    IdUrlMap map;
+    map.add(7, "seven.pl");
+    map.add(3, "three.pl");
+    map.add(7, "other-seven.pl");
+    map.add(-1, "");
+    map.add(5, "five.pl");
+    map.sort();
+
+    ASSERT_EQ(4u, map.size());
+    std::vector<int> ids;
+    for (IdUrlMap::const_iterator it = map.begin(); it != map.end(); ++it)
+        ids.push_back(it->first);
+    EXPECT_EQ((std::vector<int>{-1, 3, 5, 7}), ids);
+    EXPECT_EQ("seven.pl", map.find(7)->second);
+    EXPECT_EQ("", map.find(-1)->second);
+    EXPECT_TRUE(map.find(4) == map.end());
+    EXPECT_EQ(1u, map.count(3));
+    EXPECT_EQ(0u, map.count(8));
+
+    map.add(8, "eight.pl"); //already in order
+    map.sort();
+    EXPECT_EQ("eight.pl", map.at(4).second);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST(CsvReaderTest, SplitDropsEmptyFields)
+{
+    CsvReader reader;
+    std::vector<CsvReader::view> fields;
+    EXPECT_EQ(3u, reader.split(";31;;  45  ;costam;", fields));
+    EXPECT_EQ("31", fields[0]);
+    EXPECT_EQ("  45  ", fields[1]);
+    EXPECT_EQ("costam", fields[2]);
+    EXPECT_EQ(2u, reader.split("a;b;c;d", fields, 2));
+    EXPECT_EQ(0u, reader.split(";;;", fields));
+}
+
+TEST(CsvReaderTest, FindAcrossBlocks)
+{
+    std::string text(100, 'x');
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        text[i] = ';';
+        EXPECT_EQ(text.data() + i, CsvReader::find(text.data(), text.data() + text.size(), ';'));
+        EXPECT_EQ(text.data() + i, CsvReader::find(text.data(), text.data() + i, ';')); //not found
+        text[i] = 'x';
+    }
+}
+
+TEST(CsvReaderTest, ParseIntLikeStoi)
+{
+    int value = 0;
+    EXPECT_TRUE(CsvReader::parseInt("  45  ", value));
+    EXPECT_EQ(45, value);
+    EXPECT_TRUE(CsvReader::parseInt("-12abc", value));
+    EXPECT_EQ(-12, value);
+    EXPECT_TRUE(CsvReader::parseInt("-2147483648", value));
+    EXPECT_EQ(-2147483647 - 1, value);
+    EXPECT_FALSE(CsvReader::parseInt("2147483648", value));
+    EXPECT_FALSE(CsvReader::parseInt("zle_id", value));
+    EXPECT_FALSE(CsvReader::parseInt("+", value));
+    EXPECT_FALSE(CsvReader::parseInt("", value));
+}
+
+TEST(CsvReaderTest, Lines)
+{
+    CsvReader reader;
+    EXPECT_FALSE(reader.open("fasdfas"));
+    ASSERT_TRUE(reader.open("data/one_non_int_id.csv"));
+    CsvReader::view line;
+    std::vector<std::string> lines;
+    while (reader.nextLine(line))
+        lines.push_back(line.to_string());
+    ASSERT_EQ(3u, lines.size());
+    EXPECT_EQ("tytul/header", lines[0]);
+    EXPECT_EQ("69;costam;lozko;costam", lines[2]);
+}
+
 
 
 struct input
@@ -86,6 +171,23 @@ INSTANTIATE_TEST_CASE_P(Default, DataPrepTest, ::testing::Values(
 
 
 
+TEST(DataPrepStreamTest, LivenessInInputOrder)
+{
+    DataPreprocessor data_prep;
+    ASSERT_TRUE(data_prep.filterValidDomains("csv/local_dns.csv", "output", DataPreprocessor::CHECK_LIVENESS, true));
+    std::ifstream output("output");
+    std::string line;
+    for (int expected = 40; expected > 0; --expected)
+    {
+        ASSERT_TRUE(std::getline(output, line).good());
+        std::string prefix = std::to_string(expected) + ";http://127.0.0.1:1/" + std::to_string(expected) + ";0;";
+        EXPECT_EQ(0u, line.find(prefix)) << line;
+    }
+    ASSERT_TRUE(std::getline(output, line).good()); //the repeated id is checked too, memory does not hold the ids
+    EXPECT_EQ(0u, line.find("7;http://127.0.0.1:1/repeated;0;")) << line;
+    EXPECT_FALSE(std::getline(output, line).good());
+}
+
 struct inputUrl
 {
     std::string url;
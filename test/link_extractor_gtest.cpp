@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <bayesian_webclass/link_extractor.h>
+
+static const std::string PATH("/html/body/div[@id='content']/div[@id='bodyContent']/div[@id='mw-content-text']/p");
+
+static const std::string HTML =
+        "<!DOCTYPE html><html><head><title>t</title></head><body>"
+        "<div id=\"content\"><div id=\"bodyContent\"><div id=\"mw-content-text\">"
+        "<p>A <a href=\"/wiki/Star\">star</a> and <b><a href=\"/wiki/Black_hole\">hole</a></b>"
+        "<a href=\"/wiki/File:Sun.png\">file</a> <a href=\"http://example.com/\">out</a>"
+        "<p>unclosed <a href=\"/wiki/Galaxy\">galaxy</a>"
+        "</div><div id=\"other\"><p><a href=\"/wiki/Other\">other</a></p></div>"
+        "<a href=\"/wiki/Outside\">outside</a></div></div></body></html>";
+
+TEST(LinkExtractorTest, LinksFromParagraphs)
+{
+    const std::string &html = HTML;
+    LinkExtractor extractor(PATH);
+    ASSERT_TRUE(extractor.isValid());
+
+    std::set<std::string> links;
+    EXPECT_EQ(3, extractor.extract(html, links));
+    std::set<std::string> expected = {"Star", "Black_hole", "Galaxy"};
+    EXPECT_EQ(expected, links);
+}
+
+TEST(LinkExtractorTest, TokenizerMatchesSax)
+{
+    LinkExtractor extractor(PATH);
+    std::set<std::string> sax, tokenizer;
+    EXPECT_TRUE(extractor.extract(HTML, sax, SaxEventSource()));
+    EXPECT_TRUE(extractor.extract(HTML, tokenizer, TokenizerEventSource()));
+    EXPECT_EQ(sax, tokenizer);
+
+    const std::string quirks = "<html><body><div id=content><div id=bodyContent><div id=mw-content-text>"
+                               "<p><a href='/wiki/A&amp;B'>x</a><br><img src=x.png><script>if(a<b)'</p>'</script>"
+                               "<a HREF=/wiki/C>c</a><!-- <p> --><p><a href=\"/wiki/D\">d</a></div>";
+    sax.clear();
+    tokenizer.clear();
+    EXPECT_TRUE(extractor.extract(quirks, sax, SaxEventSource()));
+    EXPECT_TRUE(extractor.extract(quirks, tokenizer, TokenizerEventSource()));
+    EXPECT_EQ(sax, tokenizer);
+    EXPECT_EQ(3u, tokenizer.size());
+}
+
+TEST(LinkExtractorTest, TokenizerClosesImpliedElements)
+{
+    LinkExtractor extractor(PATH);
+    const std::string html = "<html><body><div id=content><div id=bodyContent><div id=mw-content-text>"
+                             "<p><a href=/wiki/A>a</a><p><a href=/wiki/B>b</a><p><a href=/wiki/C>c</a>"
+                             "<ul><li><a href=/wiki/D>d</a><li><a href=/wiki/E>e</a><li>f</ul>"
+                             "<p><a href=/wiki/G>g</a><p></div></div></div></body></html>";
+    std::set<std::string> sax, tokenizer;
+    EXPECT_TRUE(extractor.extract(html, sax, SaxEventSource()));
+    EXPECT_TRUE(extractor.extract(html, tokenizer, TokenizerEventSource()));
+    std::set<std::string> expected = {"A", "B", "C", "G"};
+    EXPECT_EQ(expected, tokenizer);
+    EXPECT_EQ(sax, tokenizer);
+}
+
+TEST(LinkExtractorTest, TokenizerFailsOnBrokenPage)
+{
+    LinkExtractor extractor(PATH);
+    std::set<std::string> links;
+    EXPECT_TRUE(extractor.extract("<html><body><p><a href=\"/wiki/A\">a</a></p></body></html>", links,
+                                  TokenizerEventSource())); //path not found, no links and no fallback
+    EXPECT_FALSE(extractor.extract(HTML + "<a href=\"/wiki/B", links, TokenizerEventSource()));
+    EXPECT_TRUE(links.empty());
+}
+
+TEST(LinkExtractorTest, UnsupportedPath)
+{
+    std::vector<LinkPathTracker::Step> steps;
+    EXPECT_TRUE(LinkPathTracker::parsePath("/html/*/div[@id=\"x\"]/p", steps));
+    EXPECT_EQ(4u, steps.size());
+    EXPECT_FALSE(LinkPathTracker::parsePath("//p", steps));
+    EXPECT_FALSE(LinkPathTracker::parsePath("html/body", steps));
+    EXPECT_FALSE(LinkPathTracker::parsePath("/html/p[1]", steps));
+    EXPECT_FALSE(LinkExtractor("/html/p[@class='x']").isValid());
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+        return RUN_ALL_TESTS();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Unhandled Exception: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <bayesian_webclass/page_cache.h>
+#include <bayesian_webclass/async_downloader.h>
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//local HTTP stand-in: answers with the path as the body and ETag "v1", 304 if the client already has "v1",
+//500 for paths starting with /error
+struct EtagServer
+{
+    int fd;
+    int port;
+    std::atomic<int> requests;
+    std::atomic<int> not_modified;
+    std::thread thread;
+
+    EtagServer() : fd(socket(AF_INET, SOCK_STREAM, 0)), port(0), requests(0), not_modified(0)
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(fd, (sockaddr *) &addr, len);
+        listen(fd, 16);
+        getsockname(fd, (sockaddr *) &addr, &len);
+        port = ntohs(addr.sin_port);
+        thread = std::thread(&EtagServer::accept_loop, this);
+    }
+
+    ~EtagServer()
+    {
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+        thread.join();
+    }
+
+    std::string url(const std::string &path) const
+    {
+        return "http://127.0.0.1:" + std::to_string(port) + path;
+    }
+
+    void accept_loop()
+    {
+        int client;
+        while ((client = accept(fd, nullptr, nullptr)) >= 0)
+        {
+            char buf[4096];
+            std::string request;
+            ssize_t n;
+            while (request.find("\r\n\r\n") == std::string::npos && (n = read(client, buf, sizeof(buf))) > 0)
+                request.append(buf, n);
+            ++requests;
+            std::string path = request.substr(4, request.find(' ', 4) - 4);
+            std::string response;
+            if (path.compare(0, 6, "/error") == 0)
+            {
+                response = "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 5\r\nConnection: close\r\n\r\nerror";
+            }
+            else if (request.find("If-None-Match: \"v1\"") != std::string::npos)
+            {
+                ++not_modified;
+                response = "HTTP/1.0 304 Not Modified\r\nETag: \"v1\"\r\nConnection: close\r\n\r\n";
+            }
+            else
+            {
+                response = "HTTP/1.0 200 OK\r\nETag: \"v1\"\r\nContent-Length: " + std::to_string(path.size()) +
+                           "\r\nConnection: close\r\n\r\n" + path;
+            }
+            write(client, response.data(), response.size());
+            close(client);
+        }
+    }
+};
+
+struct PageCacheTest : public ::testing::Test
+{
+    boost::filesystem::path dir;
+
+    PageCacheTest() : dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {}
+
+    ~PageCacheTest()
+    {
+        boost::filesystem::remove_all(dir);
+    }
+
+    std::string download(const PageCache &cache, const std::string &url, bool &success)
+    {
+        AsyncDownloader downloader;
+        downloader.setCache(&cache);
+        std::string result;
+        downloader.add(url, [&result, &success](const std::string &, bool ok, std::string &body) {
+            success = ok;
+            result = body;
+        });
+        downloader.run();
+        return result;
+    }
+};
+
+TEST(PageCacheUrlTest, NormaliseUrl)
+{
+    EXPECT_EQ("https://en.wikipedia.org/wiki/Star", PageCache::normaliseUrl("HTTPS://En.Wikipedia.org:443/wiki/Star#Life"));
+    EXPECT_EQ("http://example.com/", PageCache::normaliseUrl(" example.com:80 "));
+    EXPECT_EQ("http://example.com/?a=1", PageCache::normaliseUrl("http://example.com?a=1"));
+    EXPECT_EQ("http://example.com:8080/A", PageCache::normaliseUrl("http://example.com:8080/A"));
+    EXPECT_NE(PageCache::hash("http://example.com/a"), PageCache::hash("http://example.com/b"));
+}
+
+TEST(PageCacheUrlTest, ParseHeader)
+{
+    std::string etag, last_modified;
+    const std::string lines[] = {"HTTP/1.1 200 OK\r\n", "etag:  \"abc\" \r\n",
+                                 "Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT\r\n", "Content-Length: 3\r\n"};
+    for (const std::string &line : lines)
+        PageCache::parseHeader(line.data(), line.size(), etag, last_modified);
+    EXPECT_EQ("\"abc\"", etag);
+    EXPECT_EQ("Wed, 21 Oct 2015 07:28:00 GMT", last_modified);
+
+    PageCache::parseHeader("HTTP/1.1 200 OK\r\n", 17, etag, last_modified); //next response after a redirect
+    EXPECT_TRUE(etag.empty());
+    EXPECT_TRUE(last_modified.empty());
+}
+
+TEST_F(PageCacheTest, StoreAndLookup)
+{
+    PageCache cache(dir.string());
+    std::string body(10000, 'x');
+    body += std::string("\0<html>", 7);
+    PageCache::Entry entry;
+    EXPECT_FALSE(cache.lookup("http://example.com/a", entry));
+    ASSERT_TRUE(cache.store("http://example.com/a", body.data(), body.size(), "\"e\"", ""));
+
+    ASSERT_TRUE(cache.lookup("HTTP://EXAMPLE.COM/a#top", entry));
+    EXPECT_EQ("http://example.com/a", entry.url);
+    EXPECT_EQ(body, entry.body);
+    EXPECT_EQ("\"e\"", entry.etag);
+    EXPECT_TRUE(entry.last_modified.empty());
+    EXPECT_TRUE(cache.isFresh(entry));
+    ASSERT_EQ(1u, PageCache::conditionalHeaders(entry).size());
+    EXPECT_EQ("If-None-Match: \"e\"", PageCache::conditionalHeaders(entry)[0]);
+
+    EXPECT_FALSE(PageCache(dir.string(), 0).isFresh(entry));
+    entry.time = 0;
+    EXPECT_TRUE(PageCache(dir.string(), -1).isFresh(entry));
+}
+
+TEST_F(PageCacheTest, FreshPageIsNotDownloaded)
+{
+    EtagServer server;
+    PageCache cache(dir.string());
+    bool success = false;
+    EXPECT_EQ("/page", download(cache, server.url("/page"), success));
+    EXPECT_TRUE(success);
+    EXPECT_EQ("/page", download(cache, server.url("/page"), success));
+    EXPECT_TRUE(success);
+    EXPECT_EQ(1, server.requests);
+}
+
+TEST_F(PageCacheTest, StalePageIsRevalidated)
+{
+    EtagServer server;
+    PageCache stale(dir.string(), 0);
+    bool success = false;
+    EXPECT_EQ("/page", download(stale, server.url("/page"), success));
+    EXPECT_EQ("/page", download(stale, server.url("/page"), success));
+    EXPECT_TRUE(success);
+    EXPECT_EQ(2, server.requests);
+    EXPECT_EQ(1, server.not_modified);
+}
+
+TEST_F(PageCacheTest, StalePageUsedWhenOffline)
+{
+    PageCache stale(dir.string(), 0);
+    const std::string url("http://127.0.0.1:1/page");
+    ASSERT_TRUE(stale.store(url, "cached", 6, "", ""));
+    bool success = false;
+    EXPECT_EQ("cached", download(stale, url, success));
+    EXPECT_TRUE(success);
+    download(stale, "http://127.0.0.1:1/other", success);
+    EXPECT_FALSE(success);
+}
+
+TEST_F(PageCacheTest, StalePageUsedOnServerError)
+{
+    EtagServer server;
+    PageCache stale(dir.string(), 0);
+    ASSERT_TRUE(stale.store(server.url("/error"), "cached", 6, "\"v1\"", ""));
+    bool success = false;
+    EXPECT_EQ("cached", download(stale, server.url("/error"), success));
+    EXPECT_TRUE(success);
+    download(stale, server.url("/error/other"), success);
+    EXPECT_FALSE(success);
+    PageCache::Entry entry;
+    EXPECT_FALSE(stale.lookup(server.url("/error/other"), entry));
+    EXPECT_EQ(2, server.requests);
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+        return RUN_ALL_TESTS();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Unhandled Exception: " << e.what() << std::endl;
+    }
+    return 1;
+}